@@ -44,6 +44,10 @@ int main () {
 
     PropWare::SimplePort debugLEDs(PropWare::Port::P16, 8, PropWare::Pin::OUT);
 
+    // Compare the per-byte and block transfer routines before starting the
+    // echo loop
+    report_block_throughput(spi, &cs);
+
     while (1) {
         s = string;         // Set the pointer to the beginning of the string
         while (*s) {        // Loop until we read the null-terminator
@@ -53,9 +57,9 @@ int main () {
             cs.clear();  // Enable the SPI slave attached to CS
             spi->shift_out(8, (uint32_t) *s);  // Output the next character of the string
 
-            // Be sure to wait until the SPI communication has FINISHED before
+            // The send is posted: be sure to wait until it has FINISHED before
             // proceeding to set chip select high
-            spi->wait();
+            spi->fence();
             cs.set();
 
             waitcnt(CLKFREQ/100 + CNT);
@@ -80,6 +84,41 @@ int main () {
     return 0;
 }
 
+/**
+ * @brief       Shift a buffer out one byte at a time and then again as a single
+ *              block, printing the throughput of each method
+ *
+ * @param[in]   *spi    Running SPI module
+ * @param[in]   *cs     Chip select for the slave device
+ */
+void report_block_throughput (PropWare::SPI *spi, const PropWare::Pin *cs) {
+    uint8_t buffer[THROUGHPUT_BUFFER_SIZE];
+    uint32_t start, perByteMicros, blockMicros;
+    uint16_t i;
+
+    for (i = 0; i < sizeof(buffer); ++i)
+        buffer[i] = (uint8_t) i;
+
+    cs->clear();
+    start = CNT;
+    for (i = 0; i < sizeof(buffer); ++i)
+        spi->shift_out(8, buffer[i]);
+    spi->fence();
+    perByteMicros = PropWare::measure_time_interval(start);
+    cs->set();
+
+    cs->clear();
+    start = CNT;
+    spi->shift_out_block(buffer, sizeof(buffer));
+    blockMicros = PropWare::measure_time_interval(start);
+    cs->set();
+
+    printf("Per-byte: %u bytes/s\n",
+            (unsigned int) (sizeof(buffer) * 1000000ULL / perByteMicros));
+    printf("Block:    %u bytes/s\n",
+            (unsigned int) (sizeof(buffer) * 1000000ULL / blockMicros));
+}
+
 void error (const PropWare::ErrorCode err, const PropWare::SPI *spi) {
     PropWare::SimplePort debugLEDs(PropWare::Port::P16, 8, PropWare::Pin::OUT);
 
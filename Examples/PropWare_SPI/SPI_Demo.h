@@ -59,6 +59,11 @@
 /** Determine if the LSB or MSB should be sent first for each byte */
 #define BITMODE             PropWare::SPI::MSB_FIRST
 
+/** Number of bytes shifted out when comparing per-byte and block throughput */
+#define THROUGHPUT_BUFFER_SIZE  512
+
+void report_block_throughput (PropWare::SPI *spi, const PropWare::Pin *cs);
+
 void error (const PropWare::ErrorCode err, const PropWare::SPI *spi);
 
 /**@}*/
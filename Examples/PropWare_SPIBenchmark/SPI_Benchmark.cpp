@@ -0,0 +1,291 @@
+/**
+ * @file    SPI_Benchmark.cpp
+ *
+ * @author  David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SPI_Benchmark.h"
+
+
+/** SPI clock frequencies swept by benchmark_clocks(); Any at or above
+ *  SPI::MAX_CLOCK are skipped */
+static const int32_t CLOCKS[] = {100000, 250000, 500000, 1000000, 2000000,
+        4000000, 8000000};
+
+/**
+ * @brief   Run every benchmark once, printing one comma-separated line per
+ *          result
+ *
+ * Each line holds the memory model, the name of the test, its parameter (bits,
+ * bytes, mode or frequency), the result and the result's unit. Latencies are
+ * averaged over ITERATIONS calls and include the loop around each call.
+ */
+int main () {
+    PropWare::ErrorCode err;
+    PropWare::SPI *spi = PropWare::SPI::getInstance();
+
+    if ((err = spi->start(MOSI, MISO, SCLK, FREQ, MODE, BITMODE)))
+        error(err, spi);
+
+    printf("model,test,parameter,value,unit\n");
+    report("clkfreq", 0, CLKFREQ, "Hz");
+
+    if ((err = check_loopback(spi)))
+        error(err, spi);
+    if ((err = benchmark_latency(spi)))
+        error(err, spi);
+    if ((err = benchmark_blocks(spi)))
+        error(err, spi);
+    if ((err = benchmark_clocks(spi)))
+        error(err, spi);
+
+    report("done", 0, 0, "");
+    return 0;
+}
+
+/**
+ * @brief       Exchange a block with MOSI wired to MISO and count the bytes
+ *              that did not come back unchanged; Every other result is
+ *              meaningless if this is not zero
+ *
+ * @param[in]   *spi    Running SPI module
+ *
+ * @return      Returns 0 upon success, error code otherwise
+ */
+PropWare::ErrorCode check_loopback (PropWare::SPI *spi) {
+    PropWare::ErrorCode err;
+    uint8_t buffer[BLOCK_SIZE];
+    uint32_t in;
+    uint32_t mismatches = 0;
+    uint16_t i;
+
+    for (i = 0; i < sizeof(buffer); ++i)
+        buffer[i] = (uint8_t) (i * 7);
+    check_errors(spi->transfer_block(buffer, sizeof(buffer)));
+    for (i = 0; i < sizeof(buffer); ++i)
+        if ((uint8_t) (i * 7) != buffer[i])
+            ++mismatches;
+
+    check_errors(spi->transfer(32, 0x12345678, &in));
+    if (0x12345678 != in)
+        ++mismatches;
+
+    report("loopback_errors", sizeof(buffer), mismatches, "bytes");
+    return PropWare::SPI::NO_ERROR;
+}
+
+/**
+ * @brief       Average the number of clock cycles taken by each single-word
+ *              routine, from the call until the transfer is complete
+ *
+ * @param[in]   *spi    Running SPI module
+ *
+ * @return      Returns 0 upon success, error code otherwise
+ */
+PropWare::ErrorCode benchmark_latency (PropWare::SPI *spi) {
+    PropWare::ErrorCode err;
+    uint32_t start, in;
+    uint16_t i;
+
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i) {
+        check_errors(spi->shift_out(8, i));
+        check_errors(spi->fence());
+    }
+    report("shift_out", 8, (CNT - start) / ITERATIONS, "cycles");
+
+    // Posted sends queue up behind one another, so only the last is waited for
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i)
+        check_errors(spi->shift_out(8, i));
+    check_errors(spi->fence());
+    report("shift_out_posted", 8, (CNT - start) / ITERATIONS, "cycles");
+
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i)
+        check_errors(spi->shift_in(8, &in, sizeof(in)));
+    report("shift_in", 8, (CNT - start) / ITERATIONS, "cycles");
+
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i)
+        check_errors(spi->shift_in(32, &in, sizeof(in)));
+    report("shift_in", 32, (CNT - start) / ITERATIONS, "cycles");
+
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i)
+        check_errors(spi->transfer(8, i, &in));
+    report("transfer", 8, (CNT - start) / ITERATIONS, "cycles");
+
+#ifdef SPI_OPTION_FAST
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i) {
+        spi->shift_out_fast(8, i);
+        check_errors(spi->wait());
+    }
+    report("shift_out_fast", 8, (CNT - start) / ITERATIONS, "cycles");
+
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i)
+        spi->shift_in_fast(8, &in, sizeof(in));
+    report("shift_in_fast", 8, (CNT - start) / ITERATIONS, "cycles");
+#endif
+
+    // Step through all four modes so that every call changes the mode
+    start = CNT;
+    for (i = 0; i < ITERATIONS; ++i)
+        check_errors(spi->set_mode((PropWare::SPI::Mode) (i & 3)));
+    check_errors(spi->wait());
+    report("set_mode", 0, (CNT - start) / ITERATIONS, "cycles");
+
+    return spi->set_mode(MODE);
+}
+
+/**
+ * @brief       Measure the throughput of each block routine on a sector-sized
+ *              buffer, with the counter clock both off and on
+ *
+ * The block routines are the same ones that move the data block of an SD
+ * card read or write with SPI::sd_command()
+ *
+ * @param[in]   *spi    Running SPI module
+ *
+ * @return      Returns 0 upon success, error code otherwise
+ */
+PropWare::ErrorCode benchmark_blocks (PropWare::SPI *spi) {
+    PropWare::ErrorCode err;
+    uint8_t buffer[BLOCK_SIZE];
+    uint32_t start;
+    uint8_t counter;
+
+    memset(buffer, 0xa5, sizeof(buffer));
+
+    for (counter = 0; counter < 2; ++counter) {
+        check_errors(spi->set_counter_clock(counter));
+
+        start = CNT;
+        check_errors(spi->shift_out_block(buffer, sizeof(buffer)));
+        check_errors(spi->fence());
+        report(counter ? "block_out_ctr" : "block_out", sizeof(buffer),
+                bytes_per_second(sizeof(buffer), CNT - start), "B/s");
+
+        start = CNT;
+        check_errors(spi->shift_in_block(buffer, sizeof(buffer)));
+        report(counter ? "sector_in_ctr" : "sector_in", sizeof(buffer),
+                bytes_per_second(sizeof(buffer), CNT - start), "B/s");
+    }
+
+    start = CNT;
+    check_errors(spi->transfer_block(buffer, sizeof(buffer)));
+    report("block_transfer", sizeof(buffer),
+            bytes_per_second(sizeof(buffer), CNT - start), "B/s");
+
+    return PropWare::SPI::NO_ERROR;
+}
+
+/**
+ * @brief       Shift a sector out at each frequency in CLOCKS, both a byte at
+ *              a time and as one block, and compare the time taken with the
+ *              time the clock alone would need
+ *
+ * Utilization is given in parts per thousand: 1000 would mean SCLK never
+ * paused between bits
+ *
+ * @param[in]   *spi    Running SPI module
+ *
+ * @return      Returns 0 upon success, error code otherwise
+ */
+PropWare::ErrorCode benchmark_clocks (PropWare::SPI *spi) {
+    PropWare::ErrorCode err;
+    uint8_t buffer[BLOCK_SIZE];
+    int32_t actual;
+    uint32_t start, perByteCycles, blockCycles;
+    uint64_t busCycles;
+    uint16_t i;
+    uint8_t f;
+
+    memset(buffer, 0x5a, sizeof(buffer));
+
+    for (f = 0; f < sizeof(CLOCKS) / sizeof(CLOCKS[0]); ++f) {
+        if (PropWare::SPI::MAX_CLOCK <= CLOCKS[f])
+            continue;
+
+        check_errors(spi->set_clock(CLOCKS[f]));
+        check_errors(spi->get_clock(&actual));
+        report("clock", CLOCKS[f], actual, "Hz");
+
+        start = CNT;
+        for (i = 0; i < sizeof(buffer); ++i)
+            check_errors(spi->shift_out(8, buffer[i]));
+        check_errors(spi->fence());
+        perByteCycles = CNT - start;
+
+        start = CNT;
+        check_errors(spi->shift_out_block(buffer, sizeof(buffer)));
+        check_errors(spi->fence());
+        blockCycles = CNT - start;
+
+        busCycles = (uint64_t) sizeof(buffer) * 8 * CLKFREQ / actual;
+        report("byte_out", CLOCKS[f],
+                bytes_per_second(sizeof(buffer), perByteCycles), "B/s");
+        report("byte_utilization", CLOCKS[f],
+                (uint32_t) (busCycles * 1000 / perByteCycles), "permille");
+        report("block_out", CLOCKS[f],
+                bytes_per_second(sizeof(buffer), blockCycles), "B/s");
+        report("block_utilization", CLOCKS[f],
+                (uint32_t) (busCycles * 1000 / blockCycles), "permille");
+    }
+
+    return spi->set_clock(FREQ);
+}
+
+/**
+ * @brief   Convert a number of bytes moved in a number of clock cycles to bytes
+ *          per second
+ */
+uint32_t bytes_per_second (const uint32_t bytes, const uint32_t cycles) {
+    return (uint32_t) ((uint64_t) bytes * CLKFREQ / cycles);
+}
+
+/**
+ * @brief   Print one result as a line of comma-separated values
+ */
+void report (const char test[], const int32_t parameter, const uint32_t value,
+        const char unit[]) {
+    printf("%s,%s,%d,%u,%s\n", MODEL_NAME, test, (int) parameter,
+            (unsigned int) value, unit);
+}
+
+void error (const PropWare::ErrorCode err, const PropWare::SPI *spi) {
+    PropWare::SimplePort debugLEDs(PropWare::Port::P16, 8, PropWare::Pin::OUT);
+
+    if (PropWare::SPI::BEG_ERROR <= err && err <= PropWare::SPI::END_ERROR) {
+        spi->print_error_str((PropWare::SPI::ErrorCode) err);
+    } else
+        printf("Unknown error %u\n", err);
+
+    while (1) {
+        debugLEDs.write(err);
+        waitcnt(100*MILLISECOND + CNT);
+        debugLEDs.write(0);
+        waitcnt(100*MILLISECOND + CNT);
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file    SPI_Benchmark.h
+ */
+/**
+ * @brief   Measure the latency and throughput of the SPI module in loopback
+ *
+ * @author  David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPI_BENCHMARK_H_
+#define SPI_BENCHMARK_H_
+
+/**
+ * @defgroup    _propware_example_spibenchmark  SPI Benchmark
+ * @ingroup     _propware_examples
+ * @{
+ */
+
+// Includes
+#include <propeller.h>
+#include <tinyio.h>
+#include <PropWare/PropWare.h>
+#include <PropWare/spi.h>
+#include <PropWare/pin.h>
+#include <PropWare/port.h>
+
+/** Pin number for MOSI (master out - slave in); Wire it to MISO */
+#define MOSI                PropWare::Port::P0
+/** Pin number for MISO (master in - slave out); Wire it to MOSI */
+#define MISO                PropWare::Port::P1
+/** Pin number for the clock signal */
+#define SCLK                PropWare::Port::P2
+
+/** Frequency (in hertz) for the latency measurements */
+#define FREQ                1000000
+/** The SPI mode to run */
+#define MODE                PropWare::SPI::MODE_0
+/** Determine if the LSB or MSB should be sent first for each byte */
+#define BITMODE             PropWare::SPI::MSB_FIRST
+
+/** Number of calls averaged for each latency measurement */
+#define ITERATIONS          256
+/** Number of bytes in a block; The size of an SD card sector */
+#define BLOCK_SIZE          512
+
+/** Memory model the benchmark was compiled for; Printed with every result */
+#if (defined __PROPELLER_CMM__)
+#define MODEL_NAME          "cmm"
+#elif (defined __PROPELLER_XMMC__)
+#define MODEL_NAME          "xmmc"
+#elif (defined __PROPELLER_XMM__)
+#define MODEL_NAME          "xmm"
+#else
+#define MODEL_NAME          "lmm"
+#endif
+
+PropWare::ErrorCode benchmark_latency (PropWare::SPI *spi);
+
+PropWare::ErrorCode benchmark_blocks (PropWare::SPI *spi);
+
+PropWare::ErrorCode benchmark_clocks (PropWare::SPI *spi);
+
+PropWare::ErrorCode check_loopback (PropWare::SPI *spi);
+
+uint32_t bytes_per_second (const uint32_t bytes, const uint32_t cycles);
+
+void report (const char test[], const int32_t parameter, const uint32_t value,
+        const char unit[]);
+
+void error (const PropWare::ErrorCode err, const PropWare::SPI *spi);
+
+/**@}*/
+
+#endif /* SPI_BENCHMARK_H_ */
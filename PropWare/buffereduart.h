@@ -0,0 +1,466 @@
+/**
+ * @file        buffereduart.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_BUFFEREDUART_H_
+#define PROPWARE_BUFFEREDUART_H_
+
+#include <string.h>
+#include <propeller.h>
+#include <PropWare/PropWare.h>
+#include <PropWare/port.h>
+#include <PropWare/uart.h>
+
+namespace PropWare {
+
+// Symbols for assembly instructions to start new UART receive and transmit
+// cogs
+extern "C" {
+extern uint32_t _UARTRxStartCog (void *arg);
+extern uint32_t _UARTTxStartCog (void *arg);
+}
+
+/**
+ * @brief   Full duplex UART with a background receiver and transmitter: one
+ *          dedicated assembly cog watches the RX pin and stores every word in
+ *          a ring in hub RAM, another sends the words left in a FIFO
+ *
+ * Words arriving while the calling cog is busy elsewhere are kept until read
+ * with BufferedUART::read() or BufferedUART::read_array(), neither of which
+ * ever waits. The ring's size must be a power of two. Bits are sampled exactly
+ * as PropWare::FullDuplexUART::receive() samples them, at any baud rate up to
+ * CLKFREQ/108 (740,740 baud at 80 MHz), including words sent back-to-back with
+ * a single stop bit.
+ *
+ * A word with a parity or framing error (a low stop bit) is stored all the
+ * same, and counted; A word received while the ring is full is dropped, and
+ * counted as an overrun. Data width may not exceed 8 bits.
+ *
+ * The receiver takes a snapshot of the baud rate, data width, parity and RX
+ * pin when it starts; Restart it after changing any of them. The blocking
+ * PropWare::FullDuplexUART::receive() methods must not be used while the
+ * receiver is running.
+ *
+ * While the transmitter is running, send(), send_array() and puts() copy their
+ * words into the FIFO and return as soon as the last one is in; The
+ * transmitter frames each word just as PropWare::UART::send() does. When the
+ * FIFO is full, the TxPolicy given to BufferedUART::start_transmitter()
+ * decides whether to wait for room or drop the words that do not fit. Call
+ * BufferedUART::flush() to wait until everything has been sent. Without the
+ * transmitter, sending blocks as it does for any other UART.
+ */
+class BufferedUART: public PropWare::FullDuplexUART {
+    public:
+        /**
+         * @brief   Shared with the UART receive cog; Everything above head is
+         *          only read when the cog starts
+         */
+        typedef struct {
+            uint32_t rx;
+            uint32_t bitCycles;
+            uint32_t bits;
+            uint32_t msbMask;
+            uint32_t dataMask;
+            uint32_t parityMask;
+            uint32_t parityOdd;
+            uint32_t buffer;
+            uint32_t mask;
+            /** Words written to the ring; Written by the cog */
+            volatile uint32_t head;
+            /** Words read from the ring */
+            volatile uint32_t tail;
+            /** Written by the cog whenever a word is dropped */
+            volatile uint32_t overruns;
+            /** Written by the cog whenever a parity bit is wrong */
+            volatile uint32_t parityErrors;
+            /** Written by the cog whenever a stop bit is low */
+            volatile uint32_t framingErrors;
+        } RxControl;
+
+        /**
+         * @brief   Shared with the UART transmit cog; Everything above head is
+         *          only read when the cog starts
+         */
+        typedef struct {
+            uint32_t tx;
+            uint32_t bitCycles;
+            uint32_t bits;
+            uint32_t dataMask;
+            uint32_t parityMask;
+            uint32_t parityFlip;
+            uint32_t stopBitMask;
+            uint32_t buffer;
+            uint32_t mask;
+            /** Words written to the FIFO */
+            volatile uint32_t head;
+            /** Words sent from the FIFO; Written by the cog */
+            volatile uint32_t tail;
+        } TxControl;
+
+        /**
+         * What to do with words that are sent while the transmit FIFO is full
+         */
+        typedef enum {
+            /** Wait for the transmitter to make room */BLOCK_WHEN_FULL,
+            /**
+             * Discard the words that do not fit, counted by
+             * BufferedUART::get_tx_drops()
+             */
+            DROP_WHEN_FULL
+        } TxPolicy;
+
+    public:
+        /** Fewest clock cycles per bit the receive cog can keep up with */
+        static const uint32_t MIN_RX_BIT_CYCLES = 108;
+
+    public:
+        /**
+         * @brief       Initialize a UART module with both pin masks and supply
+         *              the receive ring and transmit FIFO; Neither may be used
+         *              by anything else while its cog is running
+         *
+         * @param[in]   tx          Pin mask for TX (transmit) pin
+         * @param[in]   rx          Pin mask for RX (receive) pin
+         * @param[in]   rxBuffer[]  Receive ring
+         * @param[in]   rxSize      Number of bytes in rxBuffer; A power of two
+         * @param[in]   txBuffer[]  Transmit FIFO; Only needed by
+         *                          BufferedUART::start_transmitter()
+         * @param[in]   txSize      Number of bytes in txBuffer; A power of two
+         */
+        BufferedUART (const PropWare::Port::Mask tx,
+                const PropWare::Port::Mask rx, uint8_t rxBuffer[],
+                const uint16_t rxSize, uint8_t txBuffer[] = NULL,
+                const uint16_t txSize = 0) :
+                PropWare::FullDuplexUART(tx, rx) {
+            this->m_rxBuffer = rxBuffer;
+            this->m_rxSize = rxSize;
+            this->m_rxCog = -1;
+            memset(&this->m_rxControl, 0, sizeof(this->m_rxControl));
+            this->m_txBuffer = txBuffer;
+            this->m_txSize = txSize;
+            this->m_txCog = -1;
+            this->m_txPolicy = BufferedUART::BLOCK_WHEN_FULL;
+            this->m_txDrops = 0;
+            memset(&this->m_txControl, 0, sizeof(this->m_txControl));
+        }
+
+        ~BufferedUART () {
+            this->stop_transmitter();
+            this->stop_receiver();
+        }
+
+        /**
+         * @brief   Start the receive cog with the current configuration; Any
+         *          words in the ring are discarded and all counters cleared
+         *
+         * @return  Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode start_receiver () {
+            if (8 < this->m_dataWidth)
+                return PropWare::UART::INVALID_DATA_WIDTH;
+            if (!this->m_rxSize || (this->m_rxSize & (this->m_rxSize - 1)))
+                return PropWare::UART::INVALID_BUFFER_SIZE;
+            if (BufferedUART::MIN_RX_BIT_CYCLES > this->m_bitCycles)
+                return PropWare::UART::BAUD_TOO_HIGH;
+
+            this->stop_receiver();
+
+            memset(&this->m_rxControl, 0, sizeof(this->m_rxControl));
+            this->m_rxControl.rx = this->m_rx.get_mask();
+            this->m_rxControl.bitCycles = this->m_bitCycles;
+            this->m_rxControl.bits = this->m_receivableBits;
+            this->m_rxControl.msbMask = this->m_msbMask;
+            this->m_rxControl.dataMask = this->m_dataMask;
+            if (PropWare::UART::NO_PARITY != this->m_parity)
+                this->m_rxControl.parityMask = this->m_dataMask
+                        | this->m_parityMask;
+            this->m_rxControl.parityOdd =
+                    PropWare::UART::ODD_PARITY == this->m_parity;
+            this->m_rxControl.buffer = (uint32_t) this->m_rxBuffer;
+            this->m_rxControl.mask = this->m_rxSize - 1U;
+
+            this->m_rxCog = (int8_t) PropWare::_UARTRxStartCog(
+                    (void *) &this->m_rxControl);
+            if (!this->is_receiving())
+                return PropWare::UART::COG_NOT_STARTED;
+
+            return PropWare::UART::NO_ERROR;
+        }
+
+        /**
+         * @brief   Stop the receive cog; Words still in the ring may be read
+         */
+        void stop_receiver () {
+            if (this->is_receiving()) {
+                cogstop(this->m_rxCog);
+                this->m_rxCog = -1;
+            }
+        }
+
+        /**
+         * @brief   Determine if the receive cog is running
+         */
+        bool is_receiving () const {
+            return -1 != this->m_rxCog;
+        }
+
+        /**
+         * @brief   Number of words waiting in the receive ring
+         */
+        uint16_t available () const {
+            return (uint16_t) (this->m_rxControl.head
+                    - this->m_rxControl.tail);
+        }
+
+        /**
+         * @brief   Take one word from the receive ring without waiting
+         *
+         * @return  The oldest word received, or -1 if the ring is empty
+         */
+        int32_t read () {
+            const uint32_t tail = this->m_rxControl.tail;
+            int32_t word;
+
+            if (this->m_rxControl.head == tail)
+                return -1;
+            word = this->m_rxBuffer[tail & this->m_rxControl.mask];
+
+            // Hand the slot back only once it has been copied
+            this->m_rxControl.tail = tail + 1;
+            return word;
+        }
+
+        /**
+         * @brief       Take words from the receive ring without waiting
+         *
+         * @param[out]  *buffer     Address to begin storing data words
+         * @param[in]   words       Maximum number of words to take
+         *
+         * @return      Number of words taken
+         */
+        uint32_t read_array (char *buffer, uint32_t words) {
+            const uint32_t head = this->m_rxControl.head;
+            uint32_t tail = this->m_rxControl.tail;
+
+            if (head - tail < words)
+                words = head - tail;
+            for (uint32_t i = 0; i < words; ++i, ++tail)
+                buffer[i] = (char) this->m_rxBuffer[tail
+                        & this->m_rxControl.mask];
+
+            this->m_rxControl.tail = tail;
+            return words;
+        }
+
+        /**
+         * @brief   Number of words dropped because the receive ring was full
+         */
+        uint32_t get_overruns () const {
+            return this->m_rxControl.overruns;
+        }
+
+        /**
+         * @brief   Number of words received with the wrong parity
+         */
+        uint32_t get_parity_errors () const {
+            return this->m_rxControl.parityErrors;
+        }
+
+        /**
+         * @brief   Number of words received with a low stop bit
+         */
+        uint32_t get_framing_errors () const {
+            return this->m_rxControl.framingErrors;
+        }
+
+        /**
+         * @brief       Start the transmit cog with the current configuration;
+         *              The TX pin is handed over to it
+         *
+         * @pre         Must be called from the cog that constructed this
+         *              object, which is the cog driving the TX pin until now
+         *
+         * @param[in]   policy  What to do when the FIFO is full
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode start_transmitter (
+                const BufferedUART::TxPolicy policy =
+                        BufferedUART::BLOCK_WHEN_FULL) {
+            if (8 < this->m_dataWidth)
+                return PropWare::UART::INVALID_DATA_WIDTH;
+            if (!this->m_txSize || (this->m_txSize & (this->m_txSize - 1)))
+                return PropWare::UART::INVALID_BUFFER_SIZE;
+
+            this->stop_transmitter();
+
+            memset(&this->m_txControl, 0, sizeof(this->m_txControl));
+            this->m_txControl.tx = this->m_tx.get_mask();
+            this->m_txControl.bitCycles = this->m_bitCycles;
+            this->m_txControl.bits = this->m_totalBits;
+            this->m_txControl.dataMask = this->m_dataMask;
+            if (PropWare::UART::NO_PARITY != this->m_parity)
+                this->m_txControl.parityMask = this->m_parityMask;
+            if (PropWare::UART::ODD_PARITY == this->m_parity)
+                this->m_txControl.parityFlip = this->m_parityMask;
+            this->m_txControl.stopBitMask = this->m_stopBitMask;
+            this->m_txControl.buffer = (uint32_t) this->m_txBuffer;
+            this->m_txControl.mask = this->m_txSize - 1U;
+            this->m_txPolicy = policy;
+            this->m_txDrops = 0;
+
+            this->m_txCog = (int8_t) PropWare::_UARTTxStartCog(
+                    (void *) &this->m_txControl);
+            if (!this->is_transmitting())
+                return PropWare::UART::COG_NOT_STARTED;
+
+            // Outputs of every cog are OR'd together: the line can only be
+            // pulled low by the transmitter once this cog lets go of it
+            this->m_tx.set_dir(PropWare::Port::IN);
+
+            return PropWare::UART::NO_ERROR;
+        }
+
+        /**
+         * @brief   Stop the transmit cog, once everything in the FIFO has
+         *          been sent, and drive the TX pin from this cog again
+         */
+        void stop_transmitter () {
+            if (this->is_transmitting()) {
+                this->flush();
+                this->m_tx.set();
+                this->m_tx.set_dir(PropWare::Port::OUT);
+                cogstop(this->m_txCog);
+                this->m_txCog = -1;
+            }
+        }
+
+        /**
+         * @brief   Determine if the transmit cog is running
+         */
+        bool is_transmitting () const {
+            return -1 != this->m_txCog;
+        }
+
+        /**
+         * @brief   Wait until every word in the transmit FIFO has been sent,
+         *          including its stop bits
+         */
+        void flush () const {
+            while (this->is_transmitting()
+                    && this->m_txControl.head != this->m_txControl.tail)
+                ;
+        }
+
+        /**
+         * @brief   Number of words that can be added to the transmit FIFO
+         *          without waiting
+         */
+        uint16_t tx_space () const {
+            return (uint16_t) (this->m_txSize - (this->m_txControl.head
+                    - this->m_txControl.tail));
+        }
+
+        /**
+         * @brief   Number of words discarded because the transmit FIFO was
+         *          full, since the transmitter was started
+         */
+        uint32_t get_tx_drops () const {
+            return this->m_txDrops;
+        }
+
+        /**
+         * @see PropWare::UART::send()
+         */
+        virtual void send (uint16_t originalData) const {
+            char word = (char) originalData;
+
+            if (this->is_transmitting())
+                this->send_array(&word, 1);
+            else
+                this->UART::send(originalData);
+        }
+
+        /**
+         * @brief       Add words to the transmit FIFO, or send them straight
+         *              away when the transmitter is not running
+         *
+         * @see PropWare::UART::send_array()
+         */
+        virtual void send_array (char *array, uint32_t words) const {
+            uint32_t head = this->m_txControl.head;
+            uint32_t room;
+
+            if (!this->is_transmitting()) {
+                this->UART::send_array(array, words);
+                return;
+            }
+
+            while (words) {
+                room = this->tx_space();
+                if (!room) {
+                    if (BufferedUART::DROP_WHEN_FULL == this->m_txPolicy) {
+                        this->m_txDrops += words;
+                        return;
+                    }
+                    continue;
+                }
+
+                if (room > words)
+                    room = words;
+                words -= room;
+                do {
+                    this->m_txBuffer[head & this->m_txControl.mask] = *array;
+                    ++array;
+                    ++head;
+                } while (--room);
+
+                // The words must be in place before the cog can see them
+                this->m_txControl.head = head;
+            }
+        }
+
+    protected:
+        BufferedUART::RxControl m_rxControl;
+        uint8_t *m_rxBuffer;
+        uint16_t m_rxSize;
+        int8_t m_rxCog;
+        // Written by the const send methods, just as the cog writes tail
+        mutable BufferedUART::TxControl m_txControl;
+        uint8_t *m_txBuffer;
+        uint16_t m_txSize;
+        int8_t m_txCog;
+        BufferedUART::TxPolicy m_txPolicy;
+        mutable uint32_t m_txDrops;
+
+    private:
+        // Each cog holds the address of its control block and buffer: an
+        // instance can be neither copied nor assigned
+        BufferedUART (const BufferedUART &);
+        BufferedUART& operator= (const BufferedUART &);
+};
+
+}
+
+#endif /* PROPWARE_BUFFEREDUART_H_ */
@@ -0,0 +1,673 @@
+/**
+ * @file        devicemodels.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_DEVICEMODELS_H_
+#define PROPWARE_DEVICEMODELS_H_
+
+#include <string.h>
+#include <PropWare/host/spiemulator.h>
+
+namespace PropWare {
+
+/**
+ * @brief   An n-bit shift register between MOSI and MISO: every bit shifted
+ *          out comes back n clocks later
+ *
+ * Whatever a bus sends is read back, unchanged, by the next read of the same
+ * width and bit order. Every bit received is also kept for inspection, in the
+ * order it appeared on the wire.
+ */
+class LoopbackModel: public SPIEmulator::Device {
+    public:
+        /**
+         * @param[in]   width   Length of the shift register, 1 to 32 bits
+         */
+        LoopbackModel (const uint8_t width = 8) {
+            this->m_width = width;
+            this->m_register = 0;
+            this->m_received = 0;
+            this->m_clocks = 0;
+        }
+
+        /**
+         * @brief   Last 32 bits received, the most recent in bit 0
+         */
+        uint32_t get_received () const {
+            return this->m_received;
+        }
+
+        /**
+         * @brief   SCLK periods seen while selected
+         */
+        uint32_t get_clocks () const {
+            return this->m_clocks;
+        }
+
+        virtual bool clock (const bool mosi) {
+            const bool miso = (this->m_register >> (this->m_width - 1)) & 1;
+
+            this->m_register = (this->m_register << 1) | mosi;
+            this->m_received = (this->m_received << 1) | mosi;
+            ++this->m_clocks;
+            return miso;
+        }
+
+    protected:
+        uint8_t m_width;
+        uint32_t m_register;
+        uint32_t m_received;
+        uint32_t m_clocks;
+};
+
+/**
+ * @brief   SDHC card in SPI mode, as PropWare::SD talks to it
+ *
+ * The card answers CMD0, CMD8, CMD55/ACMD41, CMD58, CMD59, CMD17 and CMD24;
+ * Anything else is an illegal command. CMD0 and CMD8 must carry a valid CRC7,
+ * as must every command and written block once CMD59 turns CRC checking on.
+ * Responses are delayed by one byte, the card stays busy for a few bytes after
+ * every write, and sectors are addressed by block number.
+ *
+ * Two faults can be injected: a card stuck busy, holding MISO low, and a
+ * corrupted CRC on the next sector read.
+ */
+class SDCardModel: public SPIEmulator::Device {
+    public:
+        static const uint16_t SECTOR_SIZE = 512;
+
+        /** Bits of R1 */
+        static const uint8_t R1_IDLE = BIT_0;
+        static const uint8_t R1_ILLEGAL_COMMAND = BIT_2;
+        static const uint8_t R1_CRC_ERROR = BIT_3;
+        static const uint8_t R1_ADDRESS_ERROR = BIT_5;
+
+        /** Data-response tokens */
+        static const uint8_t DATA_ACCEPTED = 0x05;
+        static const uint8_t DATA_CRC_ERROR = 0x0b;
+
+        /** Number of ACMD41s answered with "idle" before the card is ready */
+        static const uint8_t INIT_ATTEMPTS = 3;
+        /** Bytes the card stays busy after accepting a data block */
+        static const uint8_t WRITE_BUSY_BYTES = 4;
+
+    public:
+        /**
+         * @param[in]   sectors     Capacity of the card; Every sector reads as
+         *                          zeros until written
+         */
+        SDCardModel (const uint32_t sectors) {
+            this->m_sectors = sectors;
+            this->m_storage = new uint8_t[sectors * SDCardModel::SECTOR_SIZE]();
+            this->m_idle = true;
+            this->m_crcEnabled = false;
+            this->m_appCommand = false;
+            this->m_initAttempts = 0;
+            this->m_busyHeld = false;
+            this->m_corruptRead = false;
+            this->m_commands = 0;
+            this->m_writes = 0;
+            this->m_busyBytes = 0;
+            this->reset_transaction();
+        }
+
+        virtual ~SDCardModel () {
+            delete[] this->m_storage;
+        }
+
+        /**
+         * @brief   Copy a sector out of the card, bypassing the bus
+         */
+        void read_sector (const uint32_t address, uint8_t bytes[]) const {
+            memcpy(bytes, this->sector(address), SDCardModel::SECTOR_SIZE);
+        }
+
+        /**
+         * @brief   Copy a sector into the card, bypassing the bus
+         */
+        void write_sector (const uint32_t address, const uint8_t bytes[]) {
+            memcpy(this->sector(address), bytes, SDCardModel::SECTOR_SIZE);
+        }
+
+        /**
+         * @brief   Make the card hold MISO low, as a card that never finishes
+         *          a write does; It still receives everything sent to it
+         */
+        void hold_busy (const bool busy) {
+            this->m_busyHeld = busy;
+        }
+
+        /**
+         * @brief   Send the next sector read with a CRC that does not match its
+         *          contents
+         */
+        void corrupt_next_read () {
+            this->m_corruptRead = true;
+        }
+
+        /**
+         * @brief   Command frames received, including rejected ones
+         */
+        uint32_t get_command_count () const {
+            return this->m_commands;
+        }
+
+        /**
+         * @brief   Data blocks written to the card
+         */
+        uint32_t get_write_count () const {
+            return this->m_writes;
+        }
+
+        bool is_crc_enabled () const {
+            return this->m_crcEnabled;
+        }
+
+        /**
+         * @brief   CRC7 of a command's index and argument, in bits 7-1 with the
+         *          end bit set
+         */
+        static uint8_t crc7 (const uint8_t frame[]) {
+            uint8_t crc = 0;
+
+            for (uint8_t i = 0; i < 5; ++i)
+                for (int8_t bit = 7; bit >= 0; --bit) {
+                    const bool in = ((frame[i] >> bit) ^ (crc >> 6)) & 1;
+                    crc = (uint8_t) ((crc << 1) & 0x7f);
+                    if (in)
+                        crc ^= 0x09;
+                }
+
+            return (uint8_t) ((crc << 1) | 1);
+        }
+
+        /**
+         * @brief   CRC16-CCITT of a data block
+         */
+        static uint16_t crc16 (const uint8_t bytes[], uint16_t length) {
+            uint16_t crc = 0;
+
+            while (length--) {
+                crc ^= (uint16_t) (*bytes++ << 8);
+                for (uint8_t bit = 0; bit < 8; ++bit)
+                    if (crc & BIT_15)
+                        crc = (uint16_t) ((crc << 1) ^ 0x1021);
+                    else
+                        crc <<= 1;
+            }
+
+            return crc;
+        }
+
+    public:
+        virtual void select () {
+            this->reset_transaction();
+        }
+
+        virtual void deselect () {
+            // Anything not yet clocked out is lost, but a write in progress
+            // keeps the card busy
+            this->reset_transaction();
+        }
+
+        virtual bool clock (const bool mosi) {
+            if (0 == this->m_bit)
+                this->m_tx = this->next_byte();
+            const bool miso = !this->m_busyHeld && (this->m_tx & BIT_7);
+            this->m_tx <<= 1;
+
+            this->m_rx = (uint8_t) ((this->m_rx << 1) | mosi);
+            if (8 == ++this->m_bit) {
+                this->m_bit = 0;
+                this->receive(this->m_rx);
+            }
+
+            return miso;
+        }
+
+    protected:
+        typedef enum {
+            COMMAND,
+            WRITE_TOKEN,
+            WRITE_BLOCK
+        } State;
+
+        static const uint8_t FRAME_LENGTH = 6;
+        static const uint8_t START_BITS = 0xc0;
+        static const uint8_t COMMAND_START = 0x40;
+        static const uint8_t INDEX_BITS = 0x3f;
+        static const uint8_t DATA_START_ID = 0xfe;
+        // Powered up, high capacity, 3.2V - 3.4V
+        static const uint32_t OCR = BIT_31 | BIT_30 | BIT_21 | BIT_20;
+
+    protected:
+        uint8_t* sector (const uint32_t address) const {
+            return &this->m_storage[address * SDCardModel::SECTOR_SIZE];
+        }
+
+        void reset_transaction () {
+            this->m_state = SDCardModel::COMMAND;
+            this->m_frameLength = 0;
+            this->m_outputLength = 0;
+            this->m_outputIndex = 0;
+            this->m_bit = 0;
+            this->m_rx = 0;
+            this->m_tx = 0xff;
+        }
+
+        uint8_t next_byte () {
+            if (this->m_outputIndex < this->m_outputLength)
+                return this->m_output[this->m_outputIndex++];
+
+            this->m_outputIndex = this->m_outputLength = 0;
+            if (this->m_busyBytes) {
+                --this->m_busyBytes;
+                return 0;
+            }
+            return 0xff;
+        }
+
+        void output (const uint8_t byte) {
+            this->m_output[this->m_outputLength++] = byte;
+        }
+
+        /**
+         * @brief   R1, one byte after the end of the command
+         */
+        void respond (const uint8_t r1) {
+            this->output(0xff);
+            this->output(r1);
+        }
+
+        void receive (const uint8_t byte) {
+            switch (this->m_state) {
+                case SDCardModel::COMMAND:
+                    if (this->m_frameLength
+                            || SDCardModel::COMMAND_START
+                                    == (byte & SDCardModel::START_BITS)) {
+                        this->m_frame[this->m_frameLength++] = byte;
+                        if (SDCardModel::FRAME_LENGTH == this->m_frameLength) {
+                            this->m_frameLength = 0;
+                            this->execute();
+                        }
+                    }
+                    break;
+                case SDCardModel::WRITE_TOKEN:
+                    if (SDCardModel::DATA_START_ID == byte) {
+                        this->m_state = SDCardModel::WRITE_BLOCK;
+                        this->m_blockLength = 0;
+                    }
+                    break;
+                case SDCardModel::WRITE_BLOCK:
+                    this->m_block[this->m_blockLength++] = byte;
+                    if (sizeof(this->m_block) == this->m_blockLength) {
+                        this->m_state = SDCardModel::COMMAND;
+                        this->finish_write();
+                    }
+                    break;
+            }
+        }
+
+        void execute () {
+            const uint8_t index = this->m_frame[0] & SDCardModel::INDEX_BITS;
+            const uint32_t arg = ((uint32_t) this->m_frame[1] << 24)
+                    | ((uint32_t) this->m_frame[2] << 16)
+                    | ((uint32_t) this->m_frame[3] << 8) | this->m_frame[4];
+            const bool appCommand = this->m_appCommand;
+            const uint8_t r1 = this->m_idle ? SDCardModel::R1_IDLE : 0;
+
+            ++this->m_commands;
+            this->m_appCommand = false;
+
+            if ((this->m_crcEnabled || 0 == index || 8 == index)
+                    && SDCardModel::crc7(this->m_frame) != this->m_frame[5]) {
+                this->respond(r1 | SDCardModel::R1_CRC_ERROR);
+                return;
+            }
+
+            switch (index) {
+                case 0:
+                    this->m_idle = true;
+                    this->m_crcEnabled = false;
+                    this->m_initAttempts = 0;
+                    this->respond(SDCardModel::R1_IDLE);
+                    break;
+                case 8:
+                    // R7: voltage accepted and check pattern echoed
+                    this->respond(r1);
+                    this->output(0);
+                    this->output(0);
+                    this->output((uint8_t) ((arg >> 8) & NIBBLE_0));
+                    this->output((uint8_t) arg);
+                    break;
+                case 55:
+                    this->m_appCommand = true;
+                    this->respond(r1);
+                    break;
+                case 41:
+                    if (!appCommand) {
+                        this->respond(r1 | SDCardModel::R1_ILLEGAL_COMMAND);
+                        break;
+                    }
+                    if (SDCardModel::INIT_ATTEMPTS == ++this->m_initAttempts)
+                        this->m_idle = false;
+                    this->respond(this->m_idle ? SDCardModel::R1_IDLE : 0);
+                    break;
+                case 58:
+                    this->respond(r1);
+                    for (int8_t shift = 24; shift >= 0; shift -= 8)
+                        this->output((uint8_t) (SDCardModel::OCR >> shift));
+                    break;
+                case 59:
+                    this->m_crcEnabled = arg & BIT_0;
+                    this->respond(r1);
+                    break;
+                case 17:
+                case 24:
+                    if (this->m_idle)
+                        this->respond(r1 | SDCardModel::R1_ILLEGAL_COMMAND);
+                    else if (this->m_sectors <= arg)
+                        this->respond(SDCardModel::R1_ADDRESS_ERROR);
+                    else if (17 == index)
+                        this->start_read(arg);
+                    else {
+                        this->respond(0);
+                        this->m_writeAddress = arg;
+                        this->m_state = SDCardModel::WRITE_TOKEN;
+                    }
+                    break;
+                default:
+                    this->respond(r1 | SDCardModel::R1_ILLEGAL_COMMAND);
+            }
+        }
+
+        void start_read (const uint32_t address) {
+            const uint8_t *bytes = this->sector(address);
+            uint16_t crc = SDCardModel::crc16(bytes, SDCardModel::SECTOR_SIZE);
+
+            if (this->m_corruptRead) {
+                this->m_corruptRead = false;
+                crc ^= 1;
+            }
+
+            this->respond(0);
+            this->output(0xff);
+            this->output(SDCardModel::DATA_START_ID);
+            for (uint16_t i = 0; i < SDCardModel::SECTOR_SIZE; ++i)
+                this->output(bytes[i]);
+            this->output((uint8_t) (crc >> 8));
+            this->output((uint8_t) crc);
+        }
+
+        void finish_write () {
+            const uint16_t crc = (uint16_t) (
+                    (this->m_block[SDCardModel::SECTOR_SIZE] << 8)
+                            | this->m_block[SDCardModel::SECTOR_SIZE + 1]);
+
+            if (this->m_crcEnabled
+                    && crc != SDCardModel::crc16(this->m_block,
+                            SDCardModel::SECTOR_SIZE)) {
+                this->output(SDCardModel::DATA_CRC_ERROR);
+                return;
+            }
+
+            this->write_sector(this->m_writeAddress, this->m_block);
+            ++this->m_writes;
+            this->output(SDCardModel::DATA_ACCEPTED);
+            this->m_busyBytes = SDCardModel::WRITE_BUSY_BYTES;
+        }
+
+    protected:
+        uint32_t m_sectors;
+        uint8_t *m_storage;
+
+        bool m_idle;
+        bool m_crcEnabled;
+        bool m_appCommand;
+        uint8_t m_initAttempts;
+        bool m_busyHeld;
+        bool m_corruptRead;
+        uint32_t m_commands;
+        uint32_t m_writes;
+
+        // Bit and byte state of the current transaction
+        State m_state;
+        uint8_t m_bit;
+        uint8_t m_rx;
+        uint8_t m_tx;
+        uint8_t m_frame[SDCardModel::FRAME_LENGTH];
+        uint8_t m_frameLength;
+        uint8_t m_block[SDCardModel::SECTOR_SIZE + 2];
+        uint16_t m_blockLength;
+        uint32_t m_writeAddress;
+        uint8_t m_busyBytes;
+
+        // Bytes queued for MISO: a response and, for a read, the data block
+        uint8_t m_output[SDCardModel::SECTOR_SIZE + 8];
+        uint16_t m_outputLength;
+        uint16_t m_outputIndex;
+};
+
+/**
+ * @brief   MCP3004/MCP3008 (10-bit) or MCP3204/MCP3208 (12-bit) ADC
+ *
+ * After the start bit, the ADC reads the single-ended/differential bit and
+ * three channel bits, samples for one clock, drives a null bit and then shifts
+ * the conversion out most significant bit first. MISO floats until the null
+ * bit and changes on each falling edge of SCLK.
+ */
+class MCP3000Model: public SPIEmulator::Device {
+    public:
+        /**
+         * @param[in]   resolution  Bits per conversion: 10 or 12
+         */
+        MCP3000Model (const uint8_t resolution) {
+            this->m_resolution = resolution;
+            memset(this->m_inputs, 0, sizeof(this->m_inputs));
+            this->m_conversions = 0;
+            this->select();
+        }
+
+        /**
+         * @brief   Set the code that an input converts to
+         */
+        void set_input (const uint8_t channel, const uint16_t code) {
+            this->m_inputs[channel] = code;
+        }
+
+        /**
+         * @brief   Number of conversions started
+         */
+        uint32_t get_conversions () const {
+            return this->m_conversions;
+        }
+
+        virtual void select () {
+            this->m_started = false;
+            this->m_position = 0;
+            this->m_config = 0;
+        }
+
+        virtual bool clock (const bool mosi) {
+            if (!this->m_started) {
+                this->m_started = mosi;
+                return true;
+            }
+
+            ++this->m_position;
+            if (MCP3000Model::CONFIG_BITS >= this->m_position) {
+                this->m_config = (uint8_t) ((this->m_config << 1) | mosi);
+                return true;
+            }
+            if (MCP3000Model::SAMPLE_CLOCK == this->m_position) {
+                this->m_sample = this->convert();
+                ++this->m_conversions;
+                return true;
+            }
+            if (MCP3000Model::NULL_BIT_CLOCK == this->m_position)
+                return false;
+
+            const uint8_t bit = (uint8_t) (this->m_position
+                    - MCP3000Model::NULL_BIT_CLOCK - 1);
+            if (bit < this->m_resolution)
+                return (this->m_sample >> (this->m_resolution - 1 - bit)) & 1;
+            return false;
+        }
+
+        virtual bool drives_on_falling_edge () const {
+            return true;
+        }
+
+    protected:
+        static const uint8_t CONFIG_BITS = 4;
+        static const uint8_t SAMPLE_CLOCK = 5;
+        static const uint8_t NULL_BIT_CLOCK = 6;
+        static const uint8_t SINGLE_ENDED = BIT_3;
+        static const uint8_t CHANNEL_BITS = 0x07;
+
+    protected:
+        /**
+         * @brief   Single-ended code of the selected channel or, for a
+         *          pseudo-differential pair, the positive input less the
+         *          negative, clipped at zero
+         */
+        uint16_t convert () const {
+            const uint8_t channel = this->m_config & MCP3000Model::CHANNEL_BITS;
+
+            if (this->m_config & MCP3000Model::SINGLE_ENDED)
+                return this->m_inputs[channel];
+
+            const uint16_t positive = this->m_inputs[channel];
+            const uint16_t negative = this->m_inputs[channel ^ 1];
+            return positive > negative ? positive - negative : 0;
+        }
+
+    protected:
+        uint8_t m_resolution;
+        uint16_t m_inputs[8];
+        uint32_t m_conversions;
+
+        bool m_started;
+        uint8_t m_position;
+        uint8_t m_config;
+        uint16_t m_sample;
+};
+
+/**
+ * @brief   L3G gyroscope's register file
+ *
+ * The first byte of a transaction is the address of the first register, with
+ * bit 7 set to read and bit 6 set to step through consecutive registers; Every
+ * following byte reads or writes a register.
+ */
+class L3GModel: public SPIEmulator::Device {
+    public:
+        /** Contents of the WHO_AM_I register */
+        static const uint8_t DEVICE_ID = 0xd4;
+
+    public:
+        L3GModel () {
+            memset(this->m_registers, 0, sizeof(this->m_registers));
+            this->m_registers[L3GModel::WHO_AM_I] = L3GModel::DEVICE_ID;
+            this->m_transactions = 0;
+            this->select();
+        }
+
+        uint8_t get_register (const uint8_t address) const {
+            return this->m_registers[address & L3GModel::ADDRESS_BITS];
+        }
+
+        void set_register (const uint8_t address, const uint8_t value) {
+            this->m_registers[address & L3GModel::ADDRESS_BITS] = value;
+        }
+
+        /**
+         * @brief   Number of times the device was selected
+         */
+        uint32_t get_transactions () const {
+            return this->m_transactions;
+        }
+
+        virtual void select () {
+            this->m_bit = 0;
+            this->m_bytes = 0;
+            this->m_rx = 0;
+            this->m_read = false;
+        }
+
+        virtual void deselect () {
+            ++this->m_transactions;
+        }
+
+        virtual bool clock (const bool mosi) {
+            bool miso = true;
+
+            if (this->m_read) {
+                if (0 == this->m_bit)
+                    this->m_tx = this->m_registers[this->m_address];
+                miso = this->m_tx & BIT_7;
+                this->m_tx <<= 1;
+            }
+
+            this->m_rx = (uint8_t) ((this->m_rx << 1) | mosi);
+            if (8 == ++this->m_bit) {
+                this->m_bit = 0;
+                if (0 == this->m_bytes++) {
+                    this->m_read = this->m_rx & L3GModel::READ_BIT;
+                    this->m_increment = this->m_rx & L3GModel::INCREMENT_BIT;
+                    this->m_address = this->m_rx & L3GModel::ADDRESS_BITS;
+                } else {
+                    if (!this->m_read)
+                        this->m_registers[this->m_address] = this->m_rx;
+                    if (this->m_increment)
+                        this->m_address = (this->m_address + 1)
+                                & L3GModel::ADDRESS_BITS;
+                }
+            }
+
+            return miso;
+        }
+
+    protected:
+        static const uint8_t WHO_AM_I = 0x0f;
+        static const uint8_t READ_BIT = BIT_7;
+        static const uint8_t INCREMENT_BIT = BIT_6;
+        static const uint8_t ADDRESS_BITS = 0x3f;
+
+    protected:
+        uint8_t m_registers[L3GModel::ADDRESS_BITS + 1];
+        uint32_t m_transactions;
+
+        uint8_t m_bit;
+        uint32_t m_bytes;
+        uint8_t m_rx;
+        uint8_t m_tx;
+        bool m_read;
+        bool m_increment;
+        uint8_t m_address;
+};
+
+}
+
+#endif /* PROPWARE_DEVICEMODELS_H_ */
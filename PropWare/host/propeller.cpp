@@ -0,0 +1,132 @@
+/**
+ * @file        propeller.cpp
+ *
+ * @brief       Cogs, locks and the system counter of the Propeller, emulated
+ *              with host threads
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <propeller.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+volatile uint32_t DIRA, OUTA, INA;
+
+uint32_t _clkfreq = 80000000;
+
+// Cog 0 runs main(); Every other cog is a thread started by cogstart()
+static thread_local int g_cogid = 0;
+static std::thread g_cogs[_HOST_COG_COUNT];
+static std::atomic<bool> g_stopping[_HOST_COG_COUNT];
+static std::mutex g_cogMutex;
+
+// Zero-initialized, so usable by constructors that run before main()
+static std::atomic<bool> g_lockAllocated[_HOST_LOCK_COUNT];
+static std::atomic<bool> g_lockState[_HOST_LOCK_COUNT];
+
+uint32_t _host_cnt (void) {
+    const static std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    const uint64_t ns = (uint64_t) std::chrono::duration_cast<
+            std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+    return (uint32_t) (ns * (_clkfreq / 1000000) / 1000);
+}
+
+void waitcnt (const uint32_t target) {
+    while (0 < (int32_t) (target - _host_cnt()))
+        std::this_thread::yield();
+}
+
+void waitpeq (const uint32_t state, const uint32_t mask) {
+    while ((INA & mask) != state)
+        std::this_thread::yield();
+}
+
+void waitpne (const uint32_t state, const uint32_t mask) {
+    while ((INA & mask) == state)
+        std::this_thread::yield();
+}
+
+int cogid (void) {
+    return g_cogid;
+}
+
+int cogstart (void (*func) (void *par), void *par, void *stack,
+        size_t stacksize) {
+    // Every thread has its own stack on the host
+    (void) stack;
+    (void) stacksize;
+
+    std::lock_guard<std::mutex> guard(g_cogMutex);
+    for (int id = 1; id < _HOST_COG_COUNT; ++id)
+        if (!g_cogs[id].joinable()) {
+            g_stopping[id] = false;
+            g_cogs[id] = std::thread([id, func, par] () {
+                g_cogid = id;
+                func(par);
+            });
+            return id;
+        }
+    return -1;
+}
+
+void cogstop (const int id) {
+    if (id == g_cogid)
+        // A cog stopping itself has nowhere to return to
+        std::terminate();
+
+    std::lock_guard<std::mutex> guard(g_cogMutex);
+    if (0 < id && id < _HOST_COG_COUNT && g_cogs[id].joinable()) {
+        g_stopping[id] = true;
+        g_cogs[id].join();
+    }
+}
+
+int _host_cog_stopping (void) {
+    return g_stopping[g_cogid];
+}
+
+int locknew (void) {
+    for (int lock = 0; lock < _HOST_LOCK_COUNT; ++lock)
+        if (!g_lockAllocated[lock].exchange(true)) {
+            g_lockState[lock] = false;
+            return lock;
+        }
+    return -1;
+}
+
+void lockret (const int lock) {
+    g_lockAllocated[lock] = false;
+}
+
+int lockset (const int lock) {
+    return g_lockState[lock].exchange(true) ? -1 : 0;
+}
+
+int lockclr (const int lock) {
+    return g_lockState[lock].exchange(false) ? -1 : 0;
+}
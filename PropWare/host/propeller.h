@@ -0,0 +1,106 @@
+/**
+ * @file        propeller.h
+ *
+ * @brief       Stand-in for PropGCC's propeller.h when PropWare is compiled for
+ *              a Linux host; Cogs are threads and the system counter follows
+ *              the host's monotonic clock
+ *
+ * Only what PropWare's own headers use is provided. Unlike the Propeller, the
+ * I/O registers are shared by every cog (thread); Cogs started with cogstart()
+ * run on their own thread and may poll _host_cog_stopping() to learn that
+ * cogstop() was called on them
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_HOST_PROPELLER_H_
+#define PROPWARE_HOST_PROPELLER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+// PropWare declares printf() itself unless stdio.h was included first, which
+// conflicts with the host's C library
+#include <stdio.h>
+// ...and PropWare::SD has file positions of the same names
+#undef SEEK_SET
+#undef SEEK_CUR
+#undef SEEK_END
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of cogs, including the one running main() */
+#define _HOST_COG_COUNT     8
+/** Number of hardware locks */
+#define _HOST_LOCK_COUNT    8
+
+extern volatile uint32_t DIRA, OUTA, INA;
+
+/** System clock frequency; 80 MHz, as with a 5 MHz crystal and PLL16X */
+extern uint32_t _clkfreq;
+#define CLKFREQ             _clkfreq
+
+/**
+ * @brief   System counter, derived from the host's monotonic clock at CLKFREQ
+ */
+uint32_t _host_cnt (void);
+#define CNT                 (_host_cnt())
+
+void waitcnt (const uint32_t target);
+void waitpeq (const uint32_t state, const uint32_t mask);
+void waitpne (const uint32_t state, const uint32_t mask);
+
+int cogid (void);
+int cogstart (void (*func) (void *par), void *par, void *stack,
+        size_t stacksize);
+void cogstop (const int id);
+/**
+ * @brief   Non-zero once cogstop() has been called on the calling cog; A cog
+ *          must return from its function promptly when this is set
+ */
+int _host_cog_stopping (void);
+
+int locknew (void);
+void lockret (const int lock);
+int lockset (const int lock);
+int lockclr (const int lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+// PropGCC placement attributes mean nothing on the host
+#define _FCACHE
+#define HUBTEXT
+#define HUBDATA
+
+#ifdef __cplusplus
+// PropGCC only has abs(int), into which timeouts pass the unsigned difference
+// of two counter values; The host's overloads would make such calls ambiguous
+static inline int abs (const unsigned int x) {
+    return abs((int) x);
+}
+#endif
+
+#endif /* PROPWARE_HOST_PROPELLER_H_ */
@@ -0,0 +1,51 @@
+/**
+ * @file        spiemulator.cpp
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <PropWare/host/spiemulator.h>
+
+PropWare::SPIEmulator PropWare::SPIEmulator::s_buses[
+        PropWare::SPIEmulator::MAX_BUSES];
+std::mutex PropWare::SPIEmulator::s_bindMutex;
+
+/**
+ * @brief   Host replacement for the routine in spi_as.S that loads the SPI cog
+ *
+ * @return  Number of the cog, or -1 if no cogs are left
+ */
+extern "C" uint32_t _SPIStartCog (void *arg) {
+    return (uint32_t) cogstart(PropWare::SPIEmulator::run, arg, NULL, 0);
+}
+
+/**
+ * @brief   Host replacement for the routine in sdbus_as.S that loads the native
+ *          SD bus cog; The native bus is not emulated, so SDBus::start() fails
+ *          as though no cogs were left
+ *
+ * @return  -1
+ */
+extern "C" uint32_t _SDBusStartCog (void *arg) {
+    (void) arg;
+    return (uint32_t) -1;
+}
@@ -0,0 +1,842 @@
+/**
+ * @file        spiemulator.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_SPIEMULATOR_H_
+#define PROPWARE_SPIEMULATOR_H_
+
+#include <string.h>
+#include <mutex>
+#include <thread>
+#include <PropWare/spi.h>
+
+namespace PropWare {
+
+/**
+ * @brief   Host-side replacement for the SPI cog (spi_as.S), for running
+ *          PropWare::SPI and the drivers built on it under Linux
+ *
+ * When PropWare is built for the host (see host/CMakeLists.txt), SPI::start()
+ * launches this emulator on a thread instead of loading spi_as.S into a cog.
+ * It implements the same mailbox state machine and descriptor ring, bit for
+ * bit, but the "wire" is a set of PropWare::SPIEmulator::Device models attached
+ * to chip select and MISO pins. Every word passed through the mailbox and every
+ * SCLK period is counted, along with an estimate of the cog clock cycles the
+ * real SPI cog would have spent, so that the cost of a high-level operation
+ * (an SD sector read, an L3G burst, ...) can be measured without hardware.
+ *
+ * There is one emulator for each PropWare::SPI instance, with its own devices
+ * and counters; SPIEmulator::get() finds the emulator of a bus. Models of the
+ * devices PropWare has drivers for are found in host/devicemodels.h.
+ *
+ * Every field of the mailbox, the descriptors and SD commands that may hold a
+ * hub address is pointer-sized, so the emulator follows host pointers directly
+ * and the host build may be 32- or 64-bit.
+ *
+ * @note    The cycle counts are estimates from the instruction counts of
+ *          spi_as.S; The SPI_OPTION_STATS block is not maintained
+ */
+class SPIEmulator {
+    public:
+        /**
+         * @brief   Model of a device on the bus
+         *
+         * Devices only see the bus while their chip select is low. MISO is
+         * pulled high whenever no selected device drives it low.
+         */
+        class Device {
+            public:
+                virtual ~Device () {
+                }
+
+                /**
+                 * @brief   Chip select was driven low
+                 */
+                virtual void select () {
+                }
+
+                /**
+                 * @brief   Chip select was driven high
+                 */
+                virtual void deselect () {
+                }
+
+                /**
+                 * @brief       One SCLK period
+                 *
+                 * @param[in]   mosi    Level of MOSI during the period
+                 *
+                 * @return      Level to drive on MISO during the period
+                 */
+                virtual bool clock (const bool mosi) = 0;
+
+                /**
+                 * @brief   Whether MISO changes on the falling edge of SCLK
+                 *          whatever the mode of the bus, rather than on the
+                 *          trailing edge; With the clock idling high, the
+                 *          level of one period then remains on MISO until the
+                 *          leading edge of the next
+                 */
+                virtual bool drives_on_falling_edge () const {
+                    return false;
+                }
+        };
+
+        /**
+         * @brief   Activity of the emulated SPI cog
+         */
+        typedef struct {
+            /** Words of the mailbox read or written by the SPI cog */
+            uint32_t mailboxWords;
+            /** Descriptors executed from the ring */
+            uint32_t descriptors;
+            /** Operations executed, by function code */
+            uint32_t calls[SPI::FUNC_COUNT];
+            /** SCLK periods driven */
+            uint32_t sclkPeriods;
+            /** Estimated cog clock cycles spent executing operations */
+            uint64_t cycles;
+        } Counters;
+
+    public:
+        /** Number of devices that can be attached to each bus */
+        static const uint8_t MAX_DEVICES = 8;
+        /** Number of PropWare::SPI instances that can be emulated */
+        static const uint8_t MAX_BUSES = 4;
+
+    public:
+        /**
+         * @brief   Retrieve the emulator behind PropWare::SPI::getInstance()
+         */
+        static SPIEmulator* getInstance () {
+            return SPIEmulator::get(SPI::getInstance());
+        }
+
+        /**
+         * @brief       Retrieve the emulator of an SPI bus; It need not be
+         *              started
+         *
+         * @param[in]   *bus    The bus
+         *
+         * @return      NULL if MAX_BUSES other buses are already emulated
+         */
+        static SPIEmulator* get (const SPI *bus) {
+            return SPIEmulator::bind(&bus->m_mailbox);
+        }
+
+        /**
+         * @brief   Cog entry point, started by _SPIStartCog()
+         *
+         * @param[in]   *par    Address of the mailbox
+         */
+        static void run (void *par) {
+            SPIEmulator *emulator = SPIEmulator::bind(par);
+
+            if (NULL != emulator)
+                emulator->execute((SPI::Mailbox *) par);
+        }
+
+    public:
+        /**
+         * @brief       Place a device model on the bus; Must be called before
+         *              any traffic is addressed to it
+         *
+         * @param[in]   *device     Model of the device
+         * @param[in]   cs          Pin mask of the device's chip select
+         * @param[in]   miso        Pin mask of the pin the device drives
+         *
+         * @return      False if MAX_DEVICES are already attached
+         */
+        bool attach (Device *device, const Port::Mask cs,
+                const Port::Mask miso) {
+            if (SPIEmulator::MAX_DEVICES == this->m_deviceCount)
+                return false;
+
+            this->m_devices[this->m_deviceCount].device = device;
+            this->m_devices[this->m_deviceCount].cs = cs;
+            this->m_devices[this->m_deviceCount].miso = miso;
+            this->m_devices[this->m_deviceCount].selected = false;
+            this->m_devices[this->m_deviceCount].low = false;
+            ++this->m_deviceCount;
+            return true;
+        }
+
+        /**
+         * @brief   Remove every device from the bus
+         */
+        void detach_all () {
+            this->m_deviceCount = 0;
+        }
+
+        /**
+         * @brief       Retrieve the activity since the cog started or the last
+         *              call to SPIEmulator::reset_counters(); Only consistent
+         *              while the SPI cog is idle
+         *
+         * @param[out]  *counters   Counters are copied here
+         */
+        void get_counters (SPIEmulator::Counters *counters) const {
+            *counters = this->m_counters;
+        }
+
+        /**
+         * @brief   Clear all counters
+         */
+        void reset_counters () {
+            memset(&this->m_counters, 0, sizeof(this->m_counters));
+        }
+
+    protected:
+        /** Thrown out of any wait once cogstop() is called on the cog */
+        class Stopped {
+        };
+
+        typedef struct {
+            Device *device;
+            uint32_t cs;
+            uint32_t miso;
+            bool selected;
+            // Level driven during the last period
+            bool low;
+        } Attachment;
+
+        // Cycles per bit of the "fast" routines: five instructions each
+        static const uint8_t SEND_FAST_BIT_CYCLES = 20;
+        static const uint8_t READ_FAST_BIT_CYCLES = 20;
+        // One byte with SCLK driven by the counter module at CLKFREQ/8
+        static const uint8_t COUNTER_BYTE_CYCLES = 64;
+        // Hub access and loop overhead around every byte or operation
+        static const uint8_t OVERHEAD_CYCLES = 32;
+
+        // These must match spi.h and spi_as.S
+        static const uint32_t FUNC_BITS = BYTE_0;
+        static const uint8_t BITS_OFFSET = 8;
+        static const uint8_t GANG_COUNT_OFFSET = 16;
+        static const uint32_t GANG_MIN_DELAY = 64;
+        static const uint8_t SEQUENCE_OFFSET = 16;
+        static const uint8_t PHASE_BIT = BIT_0;
+        static const uint8_t POLARITY_BIT = BIT_1;
+        static const uint32_t NEG_ONE = (uint32_t) -1;
+        static const uint32_t QUEUE_PENDING = BIT_31;
+        static const uint8_t SD_DATA_START_ID = 0xfe;
+        static const uint8_t SD_CRC_OFFSET = 8;
+        static const uint8_t SD_PHASE_OFFSET = 16;
+        static const uint8_t SD_RESPONSE_BITS_OFFSET = 24;
+
+    protected:
+        SPIEmulator () {
+            this->m_mailboxAddress = NULL;
+            this->m_deviceCount = 0;
+            this->reset_counters();
+        }
+
+        /**
+         * @brief   Find the emulator of the bus whose mailbox is at the given
+         *          hub address, assigning a free one upon the first request
+         */
+        static SPIEmulator* bind (const volatile void *mailbox) {
+            std::lock_guard<std::mutex> guard(SPIEmulator::s_bindMutex);
+            SPIEmulator *unused = NULL;
+
+            for (uint8_t i = 0; i < SPIEmulator::MAX_BUSES; ++i) {
+                SPIEmulator *emulator = &SPIEmulator::s_buses[i];
+                if (mailbox == emulator->m_mailboxAddress)
+                    return emulator;
+                if (NULL == unused && NULL == emulator->m_mailboxAddress)
+                    unused = emulator;
+            }
+
+            if (NULL != unused)
+                unused->m_mailboxAddress = mailbox;
+            return unused;
+        }
+
+        /**
+         * @brief   The SPI cog: initialization followed by the main loop of
+         *          spi_as.S
+         */
+        void execute (SPI::Mailbox *mailbox) {
+            try {
+                this->m_mosi = mailbox->command;
+                this->m_miso = (uint32_t) mailbox->payload;
+                this->m_sclk = mailbox->result;
+                this->m_sequence = 0;
+                mailbox->done = this->m_sequence;
+                mailbox->command = this->m_sequence;
+
+                this->m_dira = this->m_mosi | this->m_sclk;
+                this->m_outa = this->m_mosi;
+                this->m_useCounter = 0;
+                // The ring directly follows the mailbox and the profile table
+                // directly follows the ring
+                this->m_queueBase = this->m_queueSlot =
+                        (SPI::Descriptor *) (mailbox + 1);
+                this->m_queueEnd = this->m_queueBase + SPI::QUEUE_LENGTH;
+                this->m_csMask = 0;
+                this->m_activeProfile = 0;
+                this->m_clkPhase = 0;
+                this->m_clkPolarity = 0;
+                this->m_bitMode = SPI::MSB_FIRST;
+                this->m_clkDelay = 0;
+
+                while (1) {
+                    this->update_selection();
+                    const uint32_t command = mailbox->command;
+                    if (this->m_sequence
+                            == (command >> SPIEmulator::SEQUENCE_OFFSET)) {
+                        if (!this->queue_poll())
+                            this->idle();
+                    } else {
+                        this->m_sequence = command
+                                >> SPIEmulator::SEQUENCE_OFFSET;
+                        this->m_data = mailbox->payload;
+                        this->m_counters.mailboxWords += 2;
+                        this->m_activeProfile = 0;
+                        this->command(command);
+
+                        // Post the completion: result first, then the sequence
+                        mailbox->result = (uint32_t) this->m_data;
+                        mailbox->done = this->m_sequence;
+                        this->m_counters.mailboxWords += 2;
+                    }
+                }
+            } catch (const SPIEmulator::Stopped &) {
+                // Returning from the cog's function ends its thread
+            }
+        }
+
+        /**
+         * @brief   Execute a command received through the mailbox; Its
+         *          payload is in, and its result left in, SPIEmulator::m_data
+         */
+        void command (const uint32_t mailbox) {
+            const uint8_t func = (uint8_t) (mailbox & SPIEmulator::FUNC_BITS);
+            const uint8_t bits = (uint8_t) (mailbox >> SPIEmulator::BITS_OFFSET);
+
+            if (func < SPI::FUNC_COUNT)
+                ++this->m_counters.calls[func];
+            this->m_counters.cycles += SPIEmulator::OVERHEAD_CYCLES;
+
+            switch (func) {
+                case SPI::FUNC_SEND_FAST:
+                    this->shift(this->m_data, bits,
+                            SPIEmulator::SEND_FAST_BIT_CYCLES);
+                    this->m_outa |= this->m_mosi;
+                    break;
+                case SPI::FUNC_READ_FAST:
+                    this->m_data = this->shift_in(bits,
+                            SPIEmulator::READ_FAST_BIT_CYCLES);
+                    break;
+                case SPI::FUNC_SD_COMMAND:
+                    this->sd_command();
+                    break;
+                case SPI::FUNC_SET_MODE:
+                    this->apply_mode(this->m_data);
+                    break;
+                case SPI::FUNC_SET_BITMODE:
+                    this->m_bitMode = this->m_data;
+                    break;
+                case SPI::FUNC_SET_FREQ:
+                    this->m_clkDelay = this->m_data;
+                    break;
+                case SPI::FUNC_GET_FREQ:
+                    this->m_data = this->m_clkDelay;
+                    break;
+                case SPI::FUNC_SET_CTR_CLK:
+                    this->m_useCounter = this->m_data;
+                    break;
+            }
+        }
+
+        /**
+         * @brief   Execute the descriptor at the head of the ring, if the C cog
+         *          has marked it pending
+         *
+         * @return  True if a descriptor was executed
+         */
+        bool queue_poll () {
+            SPI::Descriptor *slot = this->m_queueSlot;
+            uint32_t op = slot->op;
+            if (!(op & SPIEmulator::QUEUE_PENDING))
+                return false;
+
+            uintptr_t data = slot->data;
+            const uintptr_t length = slot->length;
+            const uint8_t bits = (uint8_t) (op >> SPIEmulator::BITS_OFFSET);
+            op &= SPIEmulator::FUNC_BITS;
+
+            ++this->m_counters.descriptors;
+            if (op < SPI::FUNC_COUNT)
+                ++this->m_counters.calls[op];
+            this->m_counters.cycles += SPIEmulator::OVERHEAD_CYCLES;
+
+            switch (op) {
+                case SPI::FUNC_SEND:
+                case SPI::FUNC_TRANSFER:
+                    data = this->shift((uint32_t) data, bits,
+                            this->bit_cycles());
+                    break;
+                case SPI::FUNC_READ:
+                    data = this->shift_in(bits, this->bit_cycles());
+                    break;
+                case SPI::FUNC_GANG_TRANSFER:
+                    this->gang_transfer((uint32_t) data, bits,
+                            (SPIBus::GangChannel *) length,
+                            (uint8_t) (slot->op
+                                    >> SPIEmulator::GANG_COUNT_OFFSET));
+                    break;
+                case SPI::FUNC_SEND_BLOCK:
+                    this->shift_out_block(data, length);
+                    break;
+                case SPI::FUNC_READ_BLOCK:
+                    this->shift_in_block(data, length);
+                    break;
+                case SPI::FUNC_TRANSFER_BLOCK:
+                    this->transfer_block(data, length);
+                    break;
+                case SPI::FUNC_SELECT:
+                    this->chip_select(bits);
+                    this->load_profile(bits);
+                    this->m_outa &= ~this->m_csMask;
+                    break;
+                case SPI::FUNC_DESELECT:
+                    this->chip_select(bits);
+                    // The slot of the profile may be reused by the next one
+                    if (bits == this->m_activeProfile)
+                        this->m_activeProfile = 0;
+                    break;
+            }
+            this->m_outa |= this->m_mosi;
+            this->update_selection();
+
+            // Post the completion: received value first, then the operation
+            // without its pending flag
+            slot->data = data;
+            slot->op = op;
+
+            ++this->m_queueSlot;
+            if (this->m_queueSlot == this->m_queueEnd)
+                this->m_queueSlot = this->m_queueBase;
+            return true;
+        }
+
+        /**
+         * @brief   Take ownership of a device profile's chip select and drive
+         *          it high, leaving the settings of the bus alone
+         */
+        void chip_select (const uint8_t profile) {
+            this->m_csMask = this->profile_settings(profile)->csMask;
+            this->m_outa |= this->m_csMask;
+            this->m_dira |= this->m_csMask;
+        }
+
+        /**
+         * @brief   Switch to the settings of a device profile
+         */
+        void load_profile (const uint8_t profile) {
+            if (profile == this->m_activeProfile)
+                return;
+
+            this->m_activeProfile = profile;
+            const volatile SPI::Profile *settings = this->profile_settings(
+                    profile);
+            this->apply_mode(settings->mode);
+            this->m_bitMode = settings->bitMode;
+            this->m_clkDelay = settings->clkDelay;
+        }
+
+        const volatile SPI::Profile * profile_settings (
+                const uint8_t profile) const {
+            return (const volatile SPI::Profile *) this->m_queueEnd + profile
+                    - 1;
+        }
+
+        void apply_mode (const uint32_t mode) {
+            this->m_clkPhase = mode & SPIEmulator::PHASE_BIT;
+            this->m_clkPolarity = mode & SPIEmulator::POLARITY_BIT;
+        }
+
+        /**
+         * @brief   Execute the SD card command whose hub address is in
+         *          SPIEmulator::m_data, leaving its status there: R1, the
+         *          start or data-response token and the CRC difference
+         */
+        void sd_command () {
+            SPI::SDCommand *command = (SPI::SDCommand *) this->m_data;
+            const uint32_t frame = command->frame;
+            const uint32_t timeout = command->timeout;
+            uint32_t result = SPIEmulator::NEG_ONE;
+
+            // Wait for the card to finish any write, send the command frame
+            // and poll for R1; A card that stays busy or never answers is not
+            // clocked any further, and the response is left untouched
+            if (0 != this->sd_poll(0, timeout)) {
+                this->shift(frame, 8, this->bit_cycles());
+                this->shift(command->argument, 32, this->bit_cycles());
+                this->shift(frame >> SPIEmulator::SD_CRC_OFFSET, 8,
+                        this->bit_cycles());
+                result = this->sd_poll(0xff, timeout);
+
+                if (0xff != result) {
+                    const uint8_t bits = (uint8_t) (frame
+                            >> SPIEmulator::SD_RESPONSE_BITS_OFFSET);
+                    const uint8_t phase = (uint8_t) (frame
+                            >> SPIEmulator::SD_PHASE_OFFSET);
+
+                    if (bits)
+                        command->response = this->shift(SPIEmulator::NEG_ONE,
+                                bits, this->bit_cycles());
+                    if (phase && !result)
+                        result |= this->sd_data(phase, command->block,
+                                command->length, timeout);
+                }
+            }
+
+            this->shift(SPIEmulator::NEG_ONE, 8, this->bit_cycles());
+            this->m_outa |= this->m_mosi;
+            this->m_data = result;
+        }
+
+        /**
+         * @brief   Transfer the data block of an SD command and its CRC
+         *
+         * @return  Token in bits 15-8 and, for a read, the difference between
+         *          the CRC received and the one computed in bits 31-16
+         */
+        uint32_t sd_data (const uint8_t phase, uintptr_t address,
+                uint32_t length, const uint32_t timeout) {
+            uint16_t crc = 0;
+
+            if (SPI::SD_WRITE == phase) {
+                this->shift(SPIEmulator::SD_DATA_START_ID, 8,
+                        this->bit_cycles());
+                for (; length; --length) {
+                    const uint8_t byte = *SPIEmulator::hub_byte(address++);
+                    crc = SPIEmulator::crc16(crc, byte);
+                    this->block_byte_out(byte);
+                }
+                this->shift(crc, 16, this->bit_cycles());
+                return (uint32_t) this->sd_poll(0xff, timeout) << 8;
+            }
+
+            const uint8_t token = this->sd_poll(0xff, timeout);
+            if (SPIEmulator::SD_DATA_START_ID != token)
+                return (uint32_t) token << 8;
+            for (; length; --length) {
+                const uint8_t byte = this->block_byte_in();
+                crc = SPIEmulator::crc16(crc, byte);
+                *SPIEmulator::hub_byte(address++) = byte;
+            }
+            const uint32_t received = this->shift_in(16, this->bit_cycles());
+            return ((received ^ crc) << 16) | ((uint32_t) token << 8);
+        }
+
+        /**
+         * @brief   Clock bytes in with MOSI high until one differs from `idle`
+         *          or `timeout` cog cycles have passed
+         *
+         * @return  The last byte received; Equal to `idle` upon a timeout
+         */
+        uint8_t sd_poll (const uint8_t idle, const uint32_t timeout) {
+            const uint64_t deadline = this->m_counters.cycles + timeout;
+            uint8_t byte;
+
+            do
+                byte = (uint8_t) this->shift(SPIEmulator::NEG_ONE, 8,
+                        this->bit_cycles());
+            while (idle == byte && this->m_counters.cycles < deadline);
+
+            return byte;
+        }
+
+        void shift_out_block (uintptr_t address, uintptr_t length) {
+            while (length--)
+                this->block_byte_out(*SPIEmulator::hub_byte(address++));
+        }
+
+        void shift_in_block (uintptr_t address, uintptr_t length) {
+            while (length--)
+                *SPIEmulator::hub_byte(address++) = this->block_byte_in();
+        }
+
+        void transfer_block (uintptr_t address, uintptr_t length) {
+            for (; length; --length, ++address) {
+                volatile uint8_t *byte = SPIEmulator::hub_byte(address);
+                this->m_counters.cycles += SPIEmulator::OVERHEAD_CYCLES;
+                *byte = (uint8_t) this->shift(*byte, 8, this->bit_cycles());
+            }
+        }
+
+        /**
+         * @brief   Shift one byte of a block out, clocked by the counter module
+         *          when it is enabled
+         */
+        void block_byte_out (const uint8_t byte) {
+            this->m_counters.cycles += SPIEmulator::OVERHEAD_CYCLES;
+            if (this->m_useCounter)
+                this->shift(byte, 8, SPIEmulator::COUNTER_BYTE_CYCLES >> 3);
+            else
+                this->shift(byte, 8, this->bit_cycles());
+        }
+
+        /**
+         * @brief   Shift one byte of a block in, clocked by the counter module
+         *          when it is enabled and the clock phase allows it
+         */
+        uint8_t block_byte_in () {
+            this->m_counters.cycles += SPIEmulator::OVERHEAD_CYCLES;
+            if (this->m_useCounter && !this->m_clkPhase)
+                // The counter's reads sample after the leading edge
+                return (uint8_t) this->shift_in(8,
+                        SPIEmulator::COUNTER_BYTE_CYCLES >> 3, false);
+            else
+                return (uint8_t) this->shift_in(8, this->bit_cycles());
+        }
+
+        /**
+         * @brief   Shift a word out MSB first while sampling the MISO pin of
+         *          each channel on every clock; The channels are loaded
+         *          before the first clock and stored after the last, as the
+         *          cog holds them in its registers meanwhile
+         */
+        void gang_transfer (uint32_t data, const uint8_t bits,
+                SPIBus::GangChannel channels[], const uint8_t count) {
+            SPIBus::GangChannel held[SPI::MAX_GANG_CHANNELS];
+            // Half a period leaves time for every channel's registers
+            const uint32_t halfPeriod =
+                    SPIEmulator::GANG_MIN_DELAY < this->m_clkDelay ?
+                            this->m_clkDelay : SPIEmulator::GANG_MIN_DELAY;
+
+            this->m_counters.cycles += count * SPIEmulator::OVERHEAD_CYCLES;
+            for (uint8_t i = 0; i < count; ++i)
+                held[i] = channels[i];
+
+            data <<= 32 - bits;
+            for (uint8_t bit = 0; bit < bits; ++bit) {
+                this->set_mosi(data & BIT_31);
+                data <<= 1;
+                const uint32_t ina = this->clock(halfPeriod << 1);
+
+                for (uint8_t i = 0; i < count; ++i)
+                    held[i].data = (held[i].data << 1)
+                            | !!(ina & held[i].misoMask);
+            }
+
+            this->m_counters.cycles += count * SPIEmulator::OVERHEAD_CYCLES;
+            for (uint8_t i = 0; i < count; ++i)
+                channels[i] = held[i];
+        }
+
+        /**
+         * @brief   Shift a word out on MOSI in the current bit mode
+         *
+         * @return  Bits received on MISO meanwhile
+         */
+        uint32_t shift (uint32_t data, const uint8_t bits,
+                const uint32_t cyclesPerBit) {
+            if (SPI::MSB_FIRST != this->m_bitMode)
+                data = SPIEmulator::reverse(data, bits);
+            data <<= 32 - bits;
+
+            uint32_t received = 0;
+            for (uint8_t bit = 0; bit < bits; ++bit) {
+                this->set_mosi(data & BIT_31);
+                data <<= 1;
+                received = (received << 1)
+                        | !!(this->clock(cyclesPerBit) & this->m_miso);
+            }
+
+            if (SPI::MSB_FIRST != this->m_bitMode)
+                received = SPIEmulator::reverse(received, bits);
+            return received;
+        }
+
+        /**
+         * @brief   Shift a word in from MISO in the current bit mode; MOSI is
+         *          left as is
+         *
+         * @param[in]   bits            Number of bits to be shifted in
+         * @param[in]   cyclesPerBit    Cog clock cycles per SCLK period
+         * @param[in]   ahead           Sample ahead of each leading edge
+         *                              rather than after it, as the
+         *                              bit-banged reads do with CPHA 0
+         */
+        uint32_t shift_in (const uint8_t bits, const uint32_t cyclesPerBit,
+                bool ahead = true) {
+            uint32_t received = 0;
+
+            ahead = ahead && !this->m_clkPhase;
+            for (uint8_t bit = 0; bit < bits; ++bit) {
+                uint32_t ina = this->clock(cyclesPerBit);
+                if (ahead)
+                    ina = this->m_inaAhead;
+                received = (received << 1) | !!(ina & this->m_miso);
+            }
+
+            if (SPI::MSB_FIRST != this->m_bitMode)
+                received = SPIEmulator::reverse(received, bits);
+            return received;
+        }
+
+        void set_mosi (const bool high) {
+            if (high)
+                this->m_outa |= this->m_mosi;
+            else
+                this->m_outa &= ~this->m_mosi;
+        }
+
+        /**
+         * @brief   One SCLK period: every selected device sees MOSI and drives
+         *          its MISO pin
+         *
+         * The state of the input pins just ahead of the leading edge is left
+         * in SPIEmulator::m_inaAhead
+         *
+         * @return  State of the input pins sampled during the period
+         */
+        uint32_t clock (const uint32_t cycles) {
+            const bool mosi = (this->m_outa & this->m_mosi) != 0;
+            uint32_t ina = (uint32_t) -1;
+
+            this->m_inaAhead = (uint32_t) -1;
+            this->update_selection();
+            for (uint8_t i = 0; i < this->m_deviceCount; ++i) {
+                Attachment *attachment = &this->m_devices[i];
+                if (!attachment->selected)
+                    continue;
+
+                // A device that changes MISO on the leading edge still holds
+                // the level of the last period ahead of it
+                const bool changesOnLeadingEdge = this->m_clkPolarity
+                        && attachment->device->drives_on_falling_edge();
+                if (changesOnLeadingEdge && attachment->low)
+                    this->m_inaAhead &= ~attachment->miso;
+
+                attachment->low = !attachment->device->clock(mosi);
+                if (attachment->low) {
+                    ina &= ~attachment->miso;
+                    if (!changesOnLeadingEdge)
+                        this->m_inaAhead &= ~attachment->miso;
+                }
+            }
+
+            ++this->m_counters.sclkPeriods;
+            this->m_counters.cycles += cycles;
+            return ina;
+        }
+
+        /**
+         * @brief   Notify devices whose chip select changed level; Pins are
+         *          driven by either the C cogs (the shared OUTA) or this cog,
+         *          and read high when driven by neither
+         */
+        void update_selection () {
+            const uint32_t driven = DIRA | this->m_dira;
+            const uint32_t high = (DIRA & OUTA)
+                    | (this->m_dira & this->m_outa);
+            const uint32_t low = driven & ~high;
+
+            for (uint8_t i = 0; i < this->m_deviceCount; ++i) {
+                Attachment *attachment = &this->m_devices[i];
+                const bool selected = (low & attachment->cs)
+                        == attachment->cs;
+                if (selected && !attachment->selected) {
+                    attachment->low = false;
+                    attachment->device->select();
+                }
+                else if (!selected && attachment->selected)
+                    attachment->device->deselect();
+                attachment->selected = selected;
+            }
+        }
+
+        /**
+         * @brief   Cycles per bit when SCLK is bit-banged: half a period on
+         *          either side of the leading edge
+         */
+        uint32_t bit_cycles () const {
+            return this->m_clkDelay << 1;
+        }
+
+        void idle () {
+            if (_host_cog_stopping())
+                throw SPIEmulator::Stopped();
+            std::this_thread::yield();
+        }
+
+        static volatile uint8_t* hub_byte (const uintptr_t address) {
+            return (volatile uint8_t *) address;
+        }
+
+        static uint32_t reverse (uint32_t value, const uint8_t bits) {
+            uint32_t reversed = 0;
+            for (uint8_t i = 0; i < bits; ++i) {
+                reversed = (reversed << 1) | (value & 1);
+                value >>= 1;
+            }
+            return reversed;
+        }
+
+        static uint16_t crc16 (uint16_t crc, const uint8_t byte) {
+            uint8_t x = (uint8_t) ((crc >> 8) ^ byte);
+            x ^= x >> 4;
+            return (uint16_t) ((crc << 8) ^ x ^ (x << 5) ^ (x << 12));
+        }
+
+    protected:
+        static SPIEmulator s_buses[SPIEmulator::MAX_BUSES];
+        static std::mutex s_bindMutex;
+
+        // Mailbox of the bus being emulated; NULL while unassigned
+        const volatile void *m_mailboxAddress;
+        Attachment m_devices[SPIEmulator::MAX_DEVICES];
+        uint8_t m_deviceCount;
+        SPIEmulator::Counters m_counters;
+
+        // Registers of the SPI cog
+        uint32_t m_dira;
+        uint32_t m_outa;
+        uint32_t m_mosi;
+        uint32_t m_miso;
+        uint32_t m_sclk;
+        uint32_t m_clkDelay;
+        uint32_t m_clkPhase;
+        uint32_t m_clkPolarity;
+        uint32_t m_bitMode;
+        uint32_t m_useCounter;
+        uint32_t m_csMask;
+        uint32_t m_activeProfile;
+        SPI::Descriptor *m_queueBase;
+        SPI::Descriptor *m_queueSlot;
+        SPI::Descriptor *m_queueEnd;
+        uint32_t m_sequence;
+        // State of the input pins ahead of the leading edge of the last period
+        uint32_t m_inaAhead;
+        // Pointer-sized, as the payload of a command may be a hub address
+        uintptr_t m_data;
+};
+
+}
+
+#endif /* PROPWARE_SPIEMULATOR_H_ */
@@ -0,0 +1,13 @@
+/**
+ * @file        sys/null.h
+ *
+ * @brief       Stand-in for PropGCC's sys/null.h when PropWare is compiled for
+ *              a Linux host
+ */
+
+#ifndef PROPWARE_HOST_SYS_NULL_H_
+#define PROPWARE_HOST_SYS_NULL_H_
+
+#include <stddef.h>
+
+#endif /* PROPWARE_HOST_SYS_NULL_H_ */
@@ -0,0 +1,13 @@
+/**
+ * @file        sys/thread.h
+ *
+ * @brief       Stand-in for PropGCC's sys/thread.h when PropWare is compiled
+ *              for a Linux host
+ */
+
+#ifndef PROPWARE_HOST_SYS_THREAD_H_
+#define PROPWARE_HOST_SYS_THREAD_H_
+
+typedef volatile int atomic_t;
+
+#endif /* PROPWARE_HOST_SYS_THREAD_H_ */
@@ -0,0 +1,73 @@
+/**
+ * @file        hosttest.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_HOSTTEST_H_
+#define PROPWARE_HOSTTEST_H_
+
+#include <stdio.h>
+
+/**
+ * @brief   Fail the test, returning from it, unless `condition` holds
+ */
+#define expect(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)
+
+/**
+ * @brief   Fail the test, returning from it, unless the two integers are equal
+ */
+#define expect_equal(expected, actual) \
+    do { \
+        const unsigned long _expected = (unsigned long) (expected); \
+        const unsigned long _actual = (unsigned long) (actual); \
+        if (_expected != _actual) { \
+            printf("%s:%d: expected %s == %s (0x%lx), got 0x%lx\n", __FILE__, \
+                    __LINE__, #actual, #expected, _expected, _actual); \
+            return 1; \
+        } \
+    } while (0)
+
+/**
+ * @brief   Fail the test, returning from it, if a PropWare call fails
+ */
+#define expect_ok(call) expect_equal(0, call)
+
+/**
+ * @brief   Run a test, which returns non-zero upon failure, and report it
+ */
+#define run_test(test) host_test_run(#test, test)
+
+static inline int host_test_run (const char *name, int (*test) (void)) {
+    const int failed = test();
+
+    printf("%s %s\n", failed ? "FAIL" : "ok  ", name);
+    return failed;
+}
+
+#endif /* PROPWARE_HOSTTEST_H_ */
@@ -0,0 +1,263 @@
+/**
+ * @file        sd_test.cpp
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <PropWare/PropWare.h>
+#include <PropWare/spi.h>
+#include <PropWare/sd.h>
+#include <PropWare/pin.h>
+#include <PropWare/host/spiemulator.h>
+#include <PropWare/host/devicemodels.h>
+#include "hosttest.h"
+
+using namespace PropWare;
+
+static const Port::Mask MOSI = Port::P0;
+static const Port::Mask MISO = Port::P1;
+static const Port::Mask SCLK = Port::P2;
+static const Port::Mask CS = Port::P3;
+static const Port::Mask CS_SPARE = Port::P4;
+
+// FAT32 image: 32 reserved sectors, two FATs and one sector per cluster; The
+// root directory is cluster 2
+static const uint32_t CARD_SECTORS = 67072;
+static const uint16_t RESERVED_SECTORS = 32;
+static const uint32_t FAT_SIZE = 520;
+static const uint32_t ROOT_SECTOR = RESERVED_SECTORS + 2 * FAT_SIZE;
+static const uint32_t FILE_SECTOR = ROOT_SECTOR + 1;
+static const uint32_t FILE_LENGTH = 700;
+static const uint32_t END_OF_CHAIN = 0x0fffffff;
+
+static SPI *g_spi = SPI::getInstance();
+static SDCardModel g_card(CARD_SECTORS);
+static SDCardModel g_spareCard(1);
+static SD g_sd(g_spi);
+static SD::Buffer g_fileBuffer;
+
+static void write_16 (uint8_t bytes[], const uint16_t value) {
+    bytes[0] = (uint8_t) value;
+    bytes[1] = (uint8_t) (value >> 8);
+}
+
+static void write_32 (uint8_t bytes[], const uint32_t value) {
+    write_16(bytes, (uint16_t) value);
+    write_16(bytes + 2, (uint16_t) (value >> 16));
+}
+
+static uint8_t file_byte (const uint32_t offset) {
+    return (uint8_t) ('A' + offset % 26);
+}
+
+/**
+ * HELLO.TXT spans clusters 3 and 4
+ */
+static void format_card () {
+    uint8_t sector[SDCardModel::SECTOR_SIZE];
+
+    memset(sector, 0, sizeof(sector));
+    sector[0] = 0xeb;
+    write_16(&sector[0x0b], SDCardModel::SECTOR_SIZE);
+    sector[0x0d] = 1;
+    write_16(&sector[0x0e], RESERVED_SECTORS);
+    sector[0x10] = 2;
+    sector[0x15] = 0xf8;
+    write_32(&sector[0x20], CARD_SECTORS);
+    write_32(&sector[0x24], FAT_SIZE);
+    write_32(&sector[0x2c], 2);
+    write_16(&sector[0x1fe], 0xaa55);
+    g_card.write_sector(0, sector);
+
+    memset(sector, 0, sizeof(sector));
+    write_32(&sector[0], 0x0ffffff8);
+    write_32(&sector[4], END_OF_CHAIN);
+    write_32(&sector[8], END_OF_CHAIN);
+    write_32(&sector[12], 4);
+    write_32(&sector[16], END_OF_CHAIN);
+    g_card.write_sector(RESERVED_SECTORS, sector);
+    g_card.write_sector(RESERVED_SECTORS + FAT_SIZE, sector);
+
+    memset(sector, 0, sizeof(sector));
+    memcpy(sector, "HELLO   TXT", 11);
+    sector[0x0b] = 0x20;
+    write_16(&sector[0x1a], 3);
+    write_32(&sector[0x1c], FILE_LENGTH);
+    g_card.write_sector(ROOT_SECTOR, sector);
+
+    for (uint32_t i = 0; i < FILE_LENGTH; ++i) {
+        sector[i % SDCardModel::SECTOR_SIZE] = file_byte(i);
+        if (SDCardModel::SECTOR_SIZE - 1 == i % SDCardModel::SECTOR_SIZE
+                || FILE_LENGTH - 1 == i)
+            g_card.write_sector(FILE_SECTOR + i / SDCardModel::SECTOR_SIZE,
+                    sector);
+    }
+}
+
+static int test_crc7 () {
+    const uint8_t cmd0[] = {0x40, 0, 0, 0, 0};
+    const uint8_t cmd8[] = {0x48, 0, 0, 0x01, 0xaa};
+
+    // Values given by the SD specification
+    expect_equal(0x95, SDCardModel::crc7(cmd0));
+    expect_equal(0x87, SDCardModel::crc7(cmd8));
+    return 0;
+}
+
+static int test_start () {
+    expect_ok(g_sd.start(MOSI, MISO, SCLK, CS, -1));
+    expect(g_card.is_crc_enabled());
+    return 0;
+}
+
+static int test_read () {
+    SD::File f;
+    uint8_t buffer[2 * SDCardModel::SECTOR_SIZE];
+    uint32_t count;
+
+    f.buf = &g_fileBuffer;
+    expect_ok(g_sd.mount());
+    expect_ok(g_sd.fopen("HELLO.TXT", &f, SD::FILE_MODE_R));
+    expect_equal(FILE_LENGTH, f.length);
+    expect_ok(g_sd.fread(&f, buffer, sizeof(buffer), &count));
+    expect_equal(FILE_LENGTH, count);
+    for (uint32_t i = 0; i < FILE_LENGTH; ++i)
+        expect_equal(file_byte(i), buffer[i]);
+    expect(g_sd.feof(&f));
+    expect_ok(g_sd.fclose(&f));
+    return 0;
+}
+
+static int test_write () {
+    const uint32_t length = 300;
+    const uint32_t writes = g_card.get_write_count();
+    uint8_t sector[SDCardModel::SECTOR_SIZE];
+    uint8_t buffer[FILE_LENGTH];
+    uint32_t count;
+    SD::File f;
+
+    // Overwrite the start of the file; Its length is unchanged
+    f.buf = &g_fileBuffer;
+    expect_ok(g_sd.fopen("HELLO.TXT", &f, SD::FILE_MODE_R_PLUS));
+    for (uint32_t i = 0; i < length; ++i)
+        expect_ok(g_sd.fputc((char) ('z' - i % 26), &f));
+    expect_ok(g_sd.fclose(&f));
+    expect_ok(g_sd.unmount());
+    expect_equal(writes + 1, g_card.get_write_count());
+
+    g_card.read_sector(FILE_SECTOR, sector);
+    for (uint32_t i = 0; i < SDCardModel::SECTOR_SIZE; ++i)
+        expect_equal(i < length ? 'z' - i % 26 : file_byte(i), sector[i]);
+
+    // ...and read it back through the bus
+    expect_ok(g_sd.fopen("HELLO.TXT", &f, SD::FILE_MODE_R));
+    expect_ok(g_sd.fread(&f, buffer, sizeof(buffer), &count));
+    expect_equal(FILE_LENGTH, count);
+    for (uint32_t i = 0; i < FILE_LENGTH; ++i)
+        expect_equal(i < length ? 'z' - i % 26 : file_byte(i), buffer[i]);
+    return 0;
+}
+
+static int test_read_crc_failure () {
+    SD::File f;
+
+    f.buf = &g_fileBuffer;
+    g_card.corrupt_next_read();
+    expect_equal(SD::CRC_FAILURE, g_sd.fopen("HELLO.TXT", &f, SD::FILE_MODE_R));
+    return 0;
+}
+
+static int test_busy_card () {
+    const uint32_t commands = g_card.get_command_count();
+    SD::File f;
+    PropWare::ErrorCode err;
+
+    f.buf = &g_fileBuffer;
+    g_card.hold_busy(true);
+    err = g_sd.fopen("HELLO.TXT", &f, SD::FILE_MODE_R);
+    g_card.hold_busy(false);
+
+    expect_equal(SD::READ_TIMEOUT, err);
+    expect_equal(commands, g_card.get_command_count());
+    return 0;
+}
+
+/**
+ * An SD command to a card that never stops being busy is abandoned before the
+ * frame is sent; Neither R1 nor the rest of the response is clocked in
+ */
+static int test_sd_command_busy_timeout () {
+    const uint8_t cmd8[] = {0x48, 0, 0, 0x01, 0xaa};
+    Pin cs(CS_SPARE, Pin::OUT);
+    SPI::SDCommand command;
+    uint32_t status;
+
+    command.frame = SPI::sd_frame(cmd8[0], SDCardModel::crc7(cmd8),
+            SPI::SD_NO_DATA, 5);
+    command.argument = 0x1aa;
+    command.block = 0;
+    command.length = 0;
+    command.timeout = CLKFREQ / 1000;
+
+    g_spi->lock();
+    cs.clear();
+
+    command.response = 0x12345678;
+    g_spareCard.hold_busy(true);
+    expect_ok(g_spi->sd_command(&command, &status));
+    expect_equal(0xffffffff, status);
+    expect_equal(0x12345678, command.response);
+    expect_equal(0, g_spareCard.get_command_count());
+
+    // The same command to a card that is ready
+    g_spareCard.hold_busy(false);
+    expect_ok(g_spi->sd_command(&command, &status));
+    expect_equal(SDCardModel::R1_IDLE, status);
+    expect_equal(0x1aa, command.response);
+    expect_equal(1, g_spareCard.get_command_count());
+
+    cs.set();
+    g_spi->unlock();
+    return 0;
+}
+
+int main () {
+    SPIEmulator *emulator = SPIEmulator::get(g_spi);
+    int failures = 0;
+
+    format_card();
+    emulator->attach(&g_card, CS, MISO);
+    emulator->attach(&g_spareCard, CS_SPARE, MISO);
+
+    failures += run_test(test_crc7);
+    failures += run_test(test_start);
+    if (failures)
+        return failures;
+    failures += run_test(test_read);
+    failures += run_test(test_write);
+    failures += run_test(test_read_crc_failure);
+    failures += run_test(test_busy_card);
+    failures += run_test(test_sd_command_busy_timeout);
+
+    g_spi->stop();
+    return failures;
+}
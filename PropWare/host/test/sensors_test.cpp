@@ -0,0 +1,139 @@
+/**
+ * @file        sensors_test.cpp
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <PropWare/PropWare.h>
+#include <PropWare/spi.h>
+#include <PropWare/mcp3000.h>
+#include <PropWare/l3g.h>
+#include <PropWare/host/spiemulator.h>
+#include <PropWare/host/devicemodels.h>
+#include "hosttest.h"
+
+using namespace PropWare;
+
+static const Port::Mask MOSI = Port::P0;
+static const Port::Mask MISO = Port::P1;
+static const Port::Mask SCLK = Port::P2;
+static const Port::Mask ADC_CS = Port::P3;
+static const Port::Mask GANG_CS = Port::P4;
+static const Port::Mask GANG_MISO[] = {Port::P5, Port::P6, Port::P7};
+static const Port::Mask GYRO_CS = Port::P8;
+
+static SPI *g_spi = SPI::getInstance();
+
+static MCP3000Model g_mcp3008(10);
+static MCP3000Model g_mcp3208[] = {MCP3000Model(12), MCP3000Model(12),
+        MCP3000Model(12)};
+static L3GModel g_l3g;
+
+static int test_mcp3008 () {
+    MCP3000 adc(g_spi, MCP3000::MCP300x);
+    uint16_t value;
+
+    for (uint8_t channel = 0; channel < 8; ++channel)
+        g_mcp3008.set_input(channel, (uint16_t) (0x3ff - 0x55 * channel));
+    expect_ok(adc.start(MOSI, MISO, SCLK, ADC_CS));
+
+    for (uint8_t channel = 0; channel < 8; ++channel) {
+        expect_ok(adc.read((MCP3000::Channel) channel, &value));
+        expect_equal(0x3ff - 0x55 * channel, value);
+    }
+    expect_ok(adc.read_diff(MCP3000::DIFF_2_3, &value));
+    expect_equal(0x55, value);
+    expect_ok(adc.read_diff(MCP3000::DIFF_3_2, &value));
+    expect_equal(0, value);
+    expect_equal(10, g_mcp3008.get_conversions());
+    return 0;
+}
+
+static int test_mcp3208_gang () {
+    MCP3000 adc(g_spi, MCP3000::MCP320x);
+    SPIBus::GangChannel adcs[3];
+
+    for (uint8_t i = 0; i < 3; ++i) {
+        g_mcp3208[i].set_input(5, (uint16_t) (0xfff >> i));
+        adcs[i].misoMask = GANG_MISO[i];
+        adcs[i].data = 0;
+    }
+    expect_ok(adc.start(MOSI, MISO, SCLK, GANG_CS));
+
+    // One conversion on every ADC from a single frame
+    expect_ok(adc.read_gang(MCP3000::CHANNEL_5, adcs, 3));
+    for (uint8_t i = 0; i < 3; ++i) {
+        expect_equal(0xfff >> i, adcs[i].data);
+        expect_equal(1, g_mcp3208[i].get_conversions());
+    }
+    return 0;
+}
+
+static int test_l3g () {
+    const int16_t axes[] = {-2, 0x1234, -32768};
+    L3G gyro(g_spi);
+    int16_t values[3];
+    uint8_t id;
+
+    for (uint8_t i = 0; i < 3; ++i) {
+        g_l3g.set_register((uint8_t) (L3G::OUT_X_L + 2 * i), (uint8_t) axes[i]);
+        g_l3g.set_register((uint8_t) (L3G::OUT_X_H + 2 * i),
+                (uint8_t) (axes[i] >> 8));
+    }
+    expect_ok(gyro.start(MOSI, MISO, SCLK, GYRO_CS));
+    expect_equal(NIBBLE_0, g_l3g.get_register(L3G::CTRL_REG1));
+    expect_equal(BIT_7, g_l3g.get_register(L3G::CTRL_REG4));
+
+    expect_ok(gyro.read_register(L3G::WHO_AM_I, &id));
+    expect_equal(L3GModel::DEVICE_ID, id);
+
+    // All three axes in a single transaction
+    const uint32_t transactions = g_l3g.get_transactions();
+    expect_ok(gyro.read_all(values));
+    expect_equal(transactions + 1, g_l3g.get_transactions());
+    for (uint8_t i = 0; i < 3; ++i)
+        expect_equal(axes[i], values[i]);
+
+    expect_ok(gyro.read(L3G::Y, values));
+    expect_equal(axes[1], values[0]);
+
+    expect_ok(gyro.set_dps(L3G::DPS_2000));
+    expect_equal(BIT_7 | L3G::DPS_2000, g_l3g.get_register(L3G::CTRL_REG4));
+    return 0;
+}
+
+int main () {
+    SPIEmulator *emulator = SPIEmulator::get(g_spi);
+    int failures = 0;
+
+    emulator->attach(&g_mcp3008, ADC_CS, MISO);
+    for (uint8_t i = 0; i < 3; ++i)
+        emulator->attach(&g_mcp3208[i], GANG_CS, GANG_MISO[i]);
+    emulator->attach(&g_l3g, GYRO_CS, MISO);
+
+    failures += run_test(test_mcp3008);
+    failures += run_test(test_mcp3208_gang);
+    failures += run_test(test_l3g);
+
+    g_spi->stop();
+    return failures;
+}
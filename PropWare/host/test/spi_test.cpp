@@ -0,0 +1,220 @@
+/**
+ * @file        spi_test.cpp
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <PropWare/PropWare.h>
+#include <PropWare/spi.h>
+#include <PropWare/pin.h>
+#include <PropWare/host/spiemulator.h>
+#include <PropWare/host/devicemodels.h>
+#include "hosttest.h"
+
+using namespace PropWare;
+
+static const Port::Mask MOSI = Port::P0;
+static const Port::Mask MISO = Port::P1;
+static const Port::Mask SCLK = Port::P2;
+static const Port::Mask CS = Port::P3;
+static const Port::Mask CS_A = Port::P4;
+static const Port::Mask CS_B = Port::P5;
+static const Port::Mask GANG_CS = Port::P6;
+static const Port::Mask GANG_MISO = Port::P7;
+static const int32_t FREQ = 100000;
+
+static SPI *g_spi = SPI::getInstance();
+static SPIEmulator *g_emulator;
+
+// Selected by a chip select driven by this cog
+static LoopbackModel g_loopback;
+// Selected through device profiles
+static LoopbackModel g_loopbackA;
+static LoopbackModel g_loopbackB;
+// Share a chip select, each with its own MISO pin
+static LoopbackModel g_wide(8);
+static LoopbackModel g_narrow(4);
+
+static int test_shift_out_in () {
+    SPIEmulator::Counters counters;
+    uint8_t in;
+
+    g_emulator->reset_counters();
+    expect_ok(g_spi->shift_out(8, 0xa5));
+    expect_ok(g_spi->shift_in(8, &in, sizeof(in)));
+    expect_equal(0xa5, in);
+
+    // MOSI is held high while shifting in
+    expect_equal(0xa5ff, g_loopback.get_received() & 0xffff);
+    g_emulator->get_counters(&counters);
+    expect_equal(16, counters.sclkPeriods);
+    expect_equal(1, counters.calls[SPI::FUNC_SEND]);
+    expect_equal(1, counters.calls[SPI::FUNC_READ]);
+    return 0;
+}
+
+static int test_lsb_first () {
+    uint8_t in;
+
+    expect_ok(g_spi->set_bit_mode(SPI::LSB_FIRST));
+    expect_ok(g_spi->shift_out(8, 0x01));
+    expect_ok(g_spi->shift_in(8, &in, sizeof(in)));
+    expect_ok(g_spi->set_bit_mode(SPI::MSB_FIRST));
+
+    expect_equal(0x01, in);
+    expect_equal(0x80ff, g_loopback.get_received() & 0xffff);
+    return 0;
+}
+
+static int test_transfer () {
+    uint32_t in;
+
+    expect_ok(g_spi->shift_out(8, 0x5a));
+    expect_ok(g_spi->transfer(8, 0x3c, &in));
+    expect_equal(0x5a, in);
+    expect_ok(g_spi->transfer(8, 0x00, &in));
+    expect_equal(0x3c, in);
+    return 0;
+}
+
+static int test_transfer_block () {
+    uint8_t buffer[] = {1, 2, 3, 4};
+
+    expect_ok(g_spi->shift_out(8, 0x77));
+    expect_ok(g_spi->transfer_block(buffer, sizeof(buffer)));
+    expect_equal(0x77, buffer[0]);
+    expect_equal(1, buffer[1]);
+    expect_equal(2, buffer[2]);
+    expect_equal(3, buffer[3]);
+    return 0;
+}
+
+static int test_posted_sends () {
+    const uint8_t sends = 3 * SPI::QUEUE_LENGTH;
+    const uint32_t clocks = g_loopback.get_clocks();
+    uint8_t in;
+
+    // More sends than the descriptor ring holds, all in order
+    for (uint8_t i = 1; i <= sends; ++i)
+        expect_ok(g_spi->shift_out(8, i));
+    expect_ok(g_spi->fence());
+    expect_equal(clocks + 8 * sends, g_loopback.get_clocks());
+    expect_equal(((sends - 1) << 8) | sends,
+            g_loopback.get_received() & 0xffff);
+
+    expect_ok(g_spi->shift_in(8, &in, sizeof(in)));
+    expect_equal(sends, in);
+    return 0;
+}
+
+static int test_profiles () {
+    const uint32_t clocksA = g_loopbackA.get_clocks();
+    const uint32_t clocksB = g_loopbackB.get_clocks();
+    SPI::ProfileId idA, idB, idC;
+
+    expect_ok(g_spi->add_profile(CS_A, SPI::MODE_0, SPI::MSB_FIRST, FREQ, &idA));
+    expect_ok(g_spi->add_profile(CS_B, SPI::MODE_0, SPI::LSB_FIRST, FREQ, &idB));
+
+    // Each device only sees its own traffic, in its own bit order
+    expect_ok(g_spi->select(idA));
+    expect_ok(g_spi->shift_out(8, 0x01));
+    expect_ok(g_spi->deselect(idA));
+    expect_ok(g_spi->select(idB));
+    expect_ok(g_spi->shift_out(8, 0x01));
+    expect_ok(g_spi->deselect(idB));
+    expect_ok(g_spi->fence());
+    expect_equal(clocksA + 8, g_loopbackA.get_clocks());
+    expect_equal(0x01, g_loopbackA.get_received() & 0xff);
+    expect_equal(clocksB + 8, g_loopbackB.get_clocks());
+    expect_equal(0x80, g_loopbackB.get_received() & 0xff);
+
+    // A profile that takes over a removed one's slot brings its own settings,
+    // even though the slot's settings were the last loaded
+    expect_ok(g_spi->remove_profile(idB));
+    expect_ok(g_spi->add_profile(CS_B, SPI::MODE_0, SPI::MSB_FIRST, FREQ, &idC));
+    expect_equal(idB, idC);
+    expect_ok(g_spi->select(idC));
+    expect_ok(g_spi->shift_out(8, 0x01));
+    expect_ok(g_spi->deselect(idC));
+    expect_ok(g_spi->fence());
+    expect_equal(0x01, g_loopbackB.get_received() & 0xff);
+
+    expect_ok(g_spi->remove_profile(idA));
+    expect_ok(g_spi->remove_profile(idC));
+    return 0;
+}
+
+static int test_gang_transfer () {
+    SPIBus::GangChannel channels[2];
+    Pin cs(GANG_CS, Pin::OUT);
+
+    channels[0].misoMask = MISO;
+    channels[1].misoMask = GANG_MISO;
+
+    cs.clear();
+    for (uint8_t i = 0; i < 2; ++i) {
+        channels[0].data = channels[1].data = 0;
+        expect_ok(g_spi->gang_transfer(8, 0xa5, channels, 2));
+    }
+    cs.set();
+
+    // Every MISO pin is sampled on the same clocks
+    expect_equal(0xa5, channels[0].data & 0xff);
+    expect_equal(0x5a, channels[1].data & 0xff);
+
+    // The SPI cog holds every channel in its own registers
+    SPIBus::GangChannel tooMany[SPI::MAX_GANG_CHANNELS + 1];
+    expect_equal(SPI::TOO_MANY_CHANNELS, g_spi->gang_transfer(8, 0xa5,
+            tooMany, SPI::MAX_GANG_CHANNELS + 1));
+    return 0;
+}
+
+int main () {
+    Pin cs(CS, Pin::OUT);
+    int failures = 0;
+
+    g_emulator = SPIEmulator::get(g_spi);
+    g_emulator->attach(&g_loopback, CS, MISO);
+    g_emulator->attach(&g_loopbackA, CS_A, MISO);
+    g_emulator->attach(&g_loopbackB, CS_B, MISO);
+    g_emulator->attach(&g_wide, GANG_CS, MISO);
+    g_emulator->attach(&g_narrow, GANG_CS, GANG_MISO);
+    if (g_spi->start(MOSI, MISO, SCLK, FREQ, SPI::MODE_0, SPI::MSB_FIRST)) {
+        printf("SPI cog failed to start\n");
+        return 1;
+    }
+
+    cs.clear();
+    failures += run_test(test_shift_out_in);
+    failures += run_test(test_lsb_first);
+    failures += run_test(test_transfer);
+    failures += run_test(test_transfer_block);
+    failures += run_test(test_posted_sends);
+    g_spi->fence();
+    cs.set();
+
+    failures += run_test(test_profiles);
+    failures += run_test(test_gang_transfer);
+
+    g_spi->stop();
+    return failures;
+}
@@ -0,0 +1,507 @@
+/**
+ * @file        inlinespi.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_INLINESPI_H_
+#define PROPWARE_INLINESPI_H_
+
+#include <PropWare/PropWare.h>
+#include <PropWare/spibus.h>
+#include <PropWare/spi.h>
+
+namespace PropWare {
+
+/**
+ * @brief   SPI master that bit-bangs the bus from the calling cog
+ *
+ * No cog is started and there is no handoff between cogs, which makes this
+ * class faster than PropWare::SPI for short transfers such as single register
+ * reads. The pins, mode and bit order are fixed at compile time and the shift
+ * loop runs from the kernel's fast cache (FCache):
+ *
+ *     PropWare::InlineSPI<PropWare::Port::P0, PropWare::Port::P1,
+ *             PropWare::Port::P2, PropWare::SPIBus::MODE_3,
+ *             PropWare::SPIBus::MSB_FIRST> spi;
+ *     PropWare::L3G gyro(&spi);
+ *
+ * Every device on the bus must use the mode and bit order of the bus; Each
+ * device may still run at its own frequency. MISO is sampled just ahead of the
+ * trailing edge of each clock, as PropWare::SPI::transfer() does, which is
+ * valid for both clock phases.
+ *
+ * @note    Pins are driven by the cog that calls SPIBus::start() and
+ *          SPIBus::add_profile(); All communication must come from that cog
+ *
+ * @tparam  MOSI        Pin mask for MOSI
+ * @tparam  MISO        Pin mask for MISO
+ * @tparam  SCLK        Pin mask for SCLK
+ * @tparam  MODE        SPI mode of every device on the bus
+ * @tparam  BITMODE     Bit order of every device on the bus
+ */
+template<PropWare::Port::Mask MOSI, PropWare::Port::Mask MISO,
+        PropWare::Port::Mask SCLK, PropWare::SPIBus::Mode MODE,
+        PropWare::SPIBus::BitMode BITMODE>
+class InlineSPI: public PropWare::SPIBus {
+    public:
+        /**
+         * @brief   Clock cycles per bit of the untimed shift loop; Requests for
+         *          a higher frequency run at this rate
+         */
+        static const uint32_t UNTIMED_BIT_CYCLES = 32;
+        /**
+         * @brief   Shortest half period, in clock cycles, that the timed shift
+         *          loop can keep up with
+         */
+        static const uint32_t MIN_HALF_PERIOD = 48;
+
+    public:
+        InlineSPI () {
+            this->m_running = false;
+            this->m_halfPeriod = 0;
+            memset(this->m_profiles, 0, sizeof(this->m_profiles));
+        }
+
+        bool is_running () {
+            return this->m_running;
+        }
+
+        /**
+         * @brief       Drive the bus pins from the calling cog
+         *
+         * The pins, mode and bitmode must match the template arguments
+         *
+         * @param[in]   mosi        PinNum mask for MOSI
+         * @param[in]   miso        PinNum mask for MISO
+         * @param[in]   sclk        PinNum mask for SCLK
+         * @param[in]   frequency   Frequency, in Hz, to run the SPI clock until
+         *                          a device is selected
+         * @param[in]   mode        Must be MODE
+         * @param[in]   bitmode     Must be BITMODE
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode start (const PropWare::Port::Mask mosi,
+                const PropWare::Port::Mask miso,
+                const PropWare::Port::Mask sclk, const int32_t frequency,
+                const SPIBus::Mode mode, const SPIBus::BitMode bitmode) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (MOSI != mosi || MISO != miso || SCLK != sclk)
+                return SPI::INVALID_PIN_MASK;
+            if (0 >= frequency)
+                return SPI::INVALID_FREQ;
+#endif
+            if (MODE != mode)
+                return SPI::INVALID_MODE;
+            if (BITMODE != bitmode)
+                return SPI::INVALID_BITMODE;
+
+            this->m_halfPeriod = InlineSPI::compute_half_period(frequency);
+
+            // MOSI idles high, like the SPI cog leaves it
+            if (SPIBus::MODE_2 <= MODE)
+                OUTA |= SCLK;
+            else
+                OUTA &= ~SCLK;
+            OUTA |= MOSI;
+            DIRA |= MOSI | SCLK;
+            DIRA &= ~MISO;
+
+            this->m_running = true;
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Register a device and drive its chip select high
+         *
+         * @param[in]   cs          Pin mask for the device's chip select
+         * @param[in]   mode        Must be MODE
+         * @param[in]   bitmode     Must be BITMODE
+         * @param[in]   frequency   Frequency, in Hz, to run the SPI clock for
+         *                          the device
+         * @param[out]  *id         Identifies the new profile
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode add_profile (const PropWare::Port::Mask cs,
+                const SPIBus::Mode mode, const SPIBus::BitMode bitmode,
+                const int32_t frequency, SPIBus::ProfileId *id) {
+            Profile *profile;
+
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (0 >= frequency)
+                return SPI::INVALID_FREQ;
+#endif
+            if (MODE != mode)
+                return SPI::INVALID_MODE;
+            if (BITMODE != bitmode)
+                return SPI::INVALID_BITMODE;
+
+            // Take the first free slot; A free slot has no chip select
+            for (profile = this->m_profiles; profile->csMask; ++profile)
+                if (&this->m_profiles[SPI::MAX_PROFILES - 1] == profile)
+                    return SPI::TOO_MANY_PROFILES;
+            profile->csMask = cs;
+            profile->halfPeriod = InlineSPI::compute_half_period(frequency);
+            *id = (SPIBus::ProfileId) (profile - this->m_profiles + 1);
+
+            OUTA |= cs;
+            DIRA |= cs;
+
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode remove_profile (const SPIBus::ProfileId id) {
+            if (!this->is_profile(id))
+                return SPI::INVALID_PROFILE;
+
+            OUTA |= this->m_profiles[id - 1].csMask;
+            this->m_profiles[id - 1].csMask = 0;
+
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode select (const SPIBus::ProfileId id) {
+            if (!this->is_profile(id))
+                return SPI::INVALID_PROFILE;
+
+            this->m_halfPeriod = this->m_profiles[id - 1].halfPeriod;
+            OUTA &= ~this->m_profiles[id - 1].csMask;
+
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode deselect (const SPIBus::ProfileId id) {
+            if (!this->is_profile(id))
+                return SPI::INVALID_PROFILE;
+
+            OUTA |= this->m_profiles[id - 1].csMask;
+
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode shift_out (uint8_t bits, uint32_t value) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (0 == bits || 32 < bits)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            this->exchange(bits, value);
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode shift_in (const uint8_t bits, void *data,
+                const size_t size) {
+            uint32_t in;
+
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (0 == bits || SPI::MAX_PAR_BITS < bits)
+                return SPI::TOO_MANY_BITS;
+            if ((4 == size && ((uint32_t) data) % 4)
+                    || (2 == size && ((uint32_t) data) % 2))
+                return SPI::ADDR_MISALIGN;
+#endif
+
+            // MOSI is held high while receiving
+            in = this->exchange(bits, (uint32_t) -1);
+
+            switch (size) {
+                case sizeof(uint8_t):
+                    *((uint8_t *) data) = (uint8_t) in;
+                    break;
+                case sizeof(uint16_t):
+                    *((uint16_t *) data) = (uint16_t) in;
+                    break;
+                case sizeof(uint32_t):
+                    *((uint32_t *) data) = in;
+                    break;
+                default:
+                    return SPI::INVALID_BYTE_SIZE;
+            }
+
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode shift_out_block (const uint8_t buffer[],
+                const size_t numberOfBytes) {
+            for (size_t i = 0; i < numberOfBytes; ++i)
+                this->exchange(8, buffer[i]);
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode shift_in_block (uint8_t buffer[],
+                const size_t numberOfBytes) {
+            // MOSI is held high while receiving
+            for (size_t i = 0; i < numberOfBytes; ++i)
+                buffer[i] = (uint8_t) this->exchange(8, (uint32_t) -1);
+            return SPI::NO_ERROR;
+        }
+
+        PropWare::ErrorCode transfer (const uint8_t bits, const uint32_t out,
+                uint32_t *in) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (0 == bits || 32 < bits)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            *in = this->exchange(bits, out);
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Send a value to several devices at once while receiving
+         *              from all of them simultaneously
+         *
+         * Each device's MISO pin must be an input of the calling cog. The
+         * clock runs at the selected frequency but no faster than the loop
+         * over the channels allows
+         *
+         * @param[in]       bits        Number of bits to be exchanged
+         * @param[in]       out         The value to be shifted out
+         * @param[in,out]   channels[]  MISO pin mask of each device; The bits
+         *                              received from each device are stored
+         *                              alongside its mask
+         * @param[in]       count       Number of devices
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode gang_transfer (const uint8_t bits,
+                const uint32_t out, SPIBus::GangChannel channels[],
+                const uint8_t count) {
+            uint32_t data;
+            uint32_t in;
+            uint8_t i, j;
+
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (0 == bits || 32 < bits)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            data = out << (32 - bits);
+
+            for (i = 0; i < count; ++i)
+                channels[i].data = 0;
+
+            for (j = 0; j < bits; ++j) {
+                if (BIT_31 & data)
+                    OUTA |= MOSI;
+                else
+                    OUTA &= ~MOSI;
+                data <<= 1;
+                // Without a half period, the loop itself is the fastest rate
+                if (this->m_halfPeriod)
+                    waitcnt(this->m_halfPeriod + CNT);
+                OUTA ^= SCLK;
+                if (this->m_halfPeriod)
+                    waitcnt(this->m_halfPeriod + CNT);
+                in = INA;
+                OUTA ^= SCLK;
+
+                for (i = 0; i < count; ++i)
+                    channels[i].data = (channels[i].data << 1)
+                            | !!(channels[i].misoMask & in);
+            }
+            OUTA |= MOSI;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Sends are never posted, so there is nothing to wait for
+         */
+        PropWare::ErrorCode fence () {
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Every transfer is complete upon return, so there is never
+         *          anything to wait for
+         */
+        PropWare::ErrorCode wait () {
+            return SPI::NO_ERROR;
+        }
+
+    protected:
+        /**
+         * @brief   Settings of one device on the bus
+         */
+        typedef struct {
+            PropWare::Port::Mask csMask;
+            uint32_t halfPeriod;
+        } Profile;
+
+    protected:
+        /**
+         * @brief       Convert a frequency into the half period of the timed
+         *              shift loop, or 0 if the untimed loop should be used
+         */
+        static uint32_t compute_half_period (const int32_t frequency) {
+            const uint32_t bitCycles = CLKFREQ / frequency;
+
+            if (InlineSPI::UNTIMED_BIT_CYCLES >= bitCycles)
+                return 0;
+            else if ((InlineSPI::MIN_HALF_PERIOD << 1) > bitCycles)
+                return InlineSPI::MIN_HALF_PERIOD;
+            else
+                return bitCycles >> 1;
+        }
+
+        /**
+         * @brief       Shift a word out on MOSI while shifting a word in from
+         *              MISO
+         *
+         * @param[in]   bits    Number of bits to be exchanged; 1 through 32
+         * @param[in]   out     Value to be shifted out
+         *
+         * @return      Value shifted in
+         */
+        uint32_t exchange (const uint8_t bits, uint32_t out) const {
+            const uint32_t shift = 32 - bits;
+            uint32_t in;
+
+            // Both loops shift MSB first from bit 31
+#ifndef DOXYGEN_IGNORE
+            if (SPIBus::LSB_FIRST == BITMODE)
+                __asm__ volatile ("rev %[_out], %[_shift]"
+                        : [_out] "+r" (out)
+                        : [_shift] "r" (shift));
+#endif
+            out <<= shift;
+
+            if (this->m_halfPeriod)
+                in = InlineSPI::shift_timed(out, bits, this->m_halfPeriod);
+            else
+                in = InlineSPI::shift_untimed(out, bits);
+
+#ifndef DOXYGEN_IGNORE
+            if (SPIBus::LSB_FIRST == BITMODE)
+                __asm__ volatile ("rev %[_in], %[_shift]"
+                        : [_in] "+r" (in)
+                        : [_shift] "r" (shift));
+#endif
+
+            return in;
+        }
+
+        /**
+         * @brief       Exchange bits with a clock paced by the system counter
+         *              (FCache function)
+         *
+         * @param[in]   data        Word to be shifted out, starting at bit 31
+         * @param[in]   bits        Number of bits to be exchanged
+         * @param[in]   halfPeriod  Clock cycles per clock phase; At least
+         *                          InlineSPI::MIN_HALF_PERIOD
+         *
+         * @return      Bits shifted in, right-aligned
+         */
+#ifndef DOXYGEN_IGNORE
+        __attribute__ ((fcache))
+#endif
+        static uint32_t shift_timed (register uint32_t data,
+                register uint32_t bits, const register uint32_t halfPeriod) {
+            register uint32_t in = 0;
+#ifndef DOXYGEN_IGNORE
+            register uint32_t timer = halfPeriod + CNT;
+
+            do {
+                __asm__ volatile (
+                        "shl %[_data], #1 wc\n\t"
+                        "muxc outa, %[_mosi]\n\t"
+                        "waitcnt %[_timer], %[_halfPeriod]\n\t"
+                        "xor outa, %[_sclk]\n\t"
+                        "waitcnt %[_timer], %[_halfPeriod]\n\t"
+                        "test %[_miso], ina wc\n\t"
+                        "xor outa, %[_sclk]\n\t"
+                        "rcl %[_in], #1"
+                        : // Outputs
+                        [_data] "+r" (data),
+                        [_timer] "+r" (timer),
+                        [_in] "+r" (in)
+                        : // Inputs
+                        [_mosi] "r" (MOSI),
+                        [_miso] "r" (MISO),
+                        [_sclk] "r" (SCLK),
+                        [_halfPeriod] "r" (halfPeriod)
+                        : // Clobbers
+                        "cc");
+            } while (--bits);
+
+            OUTA |= MOSI;
+#endif
+            return in;
+        }
+
+        /**
+         * @brief       Exchange bits as quickly as the cog can toggle the clock
+         *              (FCache function)
+         *
+         * SCLK is high (or low, for modes 2 and 3) for two instructions and
+         * each bit takes roughly InlineSPI::UNTIMED_BIT_CYCLES clock cycles
+         *
+         * @param[in]   data    Word to be shifted out, starting at bit 31
+         * @param[in]   bits    Number of bits to be exchanged
+         *
+         * @return      Bits shifted in, right-aligned
+         */
+#ifndef DOXYGEN_IGNORE
+        __attribute__ ((fcache))
+#endif
+        static uint32_t shift_untimed (register uint32_t data,
+                register uint32_t bits) {
+            register uint32_t in = 0;
+#ifndef DOXYGEN_IGNORE
+
+            do {
+                __asm__ volatile (
+                        "shl %[_data], #1 wc\n\t"
+                        "muxc outa, %[_mosi]\n\t"
+                        "xor outa, %[_sclk]\n\t"
+                        "nop\n\t"
+                        "test %[_miso], ina wc\n\t"
+                        "xor outa, %[_sclk]\n\t"
+                        "rcl %[_in], #1"
+                        : // Outputs
+                        [_data] "+r" (data),
+                        [_in] "+r" (in)
+                        : // Inputs
+                        [_mosi] "r" (MOSI),
+                        [_miso] "r" (MISO),
+                        [_sclk] "r" (SCLK)
+                        : // Clobbers
+                        "cc");
+            } while (--bits);
+
+            OUTA |= MOSI;
+#endif
+            return in;
+        }
+
+    protected:
+        bool m_running;
+        uint32_t m_halfPeriod;
+        Profile m_profiles[SPI::MAX_PROFILES];
+};
+
+}
+
+#endif /* PROPWARE_INLINESPI_H_ */
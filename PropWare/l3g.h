@@ -30,6 +30,7 @@
 #include <propeller.h>
 #include <PropWare/PropWare.h>
 #include <PropWare/spi.h>
+#include <PropWare/registerdevice.h>
 
 namespace PropWare {
 
@@ -37,7 +38,7 @@ namespace PropWare {
  * @brief   L3G gyroscope driver using SPI communication for the Parallax
  *          Propeller
  */
-class L3G {
+class L3G: public PropWare::RegisterDevice<BIT_7, BIT_6, false> {
     public:
         /**
          * Axes of the L3G device
@@ -93,14 +94,14 @@ class L3G {
 
     public:
         /**
-         * @brief       Construction requires an instance of the SPI module;
-         *              the SPI module does not need to be started
+         * @brief       Construction requires an SPI bus, either
+         *              PropWare::SPI or PropWare::InlineSPI; the bus does not
+         *              need to be started
          *
-         * @param[in]   *spi    Constructed SPI module
+         * @param[in]   *spi    Constructed SPI bus
          */
-        L3G (SPI *spi) {
-            this->m_spi = spi;
-            this->m_alwaysSetMode = false;
+        L3G (SPIBus *spi) :
+                RegisterDevice(spi) {
         }
 
         /**
@@ -120,39 +121,38 @@ class L3G {
             PropWare::ErrorCode err;
 
             // Ensure SPI module started
-            if (this->m_spi->is_running()) {
-                check_errors(this->m_spi->set_mode(L3G::SPI_MODE));
-                check_errors(this->m_spi->set_bit_mode(L3G::SPI_BITMODE));
-            } else {
+            if (!this->m_spi->is_running()) {
                 check_errors(
                         this->m_spi->start(mosi, miso, sclk,
                                 L3G::SPI_DEFAULT_FREQ, L3G::SPI_MODE,
                                 L3G::SPI_BITMODE));
             }
 
-            this->m_cs.set_mask(cs);
-            this->m_cs.set_dir(PropWare::Pin::OUT);
-            this->m_cs.set();
+            // The SPI cog applies these settings and drives chip select on
+            // every access
+            check_errors(
+                    this->m_spi->add_profile(cs, L3G::SPI_MODE,
+                            L3G::SPI_BITMODE, L3G::SPI_DEFAULT_FREQ,
+                            &this->m_profile));
 
             // NOTE L3G has high- and low-pass filters. Should they be enabled?
             // (Page 31)
-            check_errors(this->write8(L3G::CTRL_REG1, NIBBLE_0));
-            check_errors(this->write8(L3G::CTRL_REG4, BIT_7));
+            check_errors(this->write_register(L3G::CTRL_REG1, NIBBLE_0));
+            check_errors(this->write_register(L3G::CTRL_REG4, BIT_7));
 
             return 0;
         }
 
         /**
-         * @brief       Choose whether to always set the SPI mode and bitmode
-         *              before reading or writing to the L3G module; Useful when
-         *              multiple devices are connected to the SPI bus
+         * @brief       Retained for compatibility; The SPI mode and bitmode are
+         *              now applied by the SPI cog whenever the L3G module is
+         *              selected (see PropWare::SPI::add_profile()), so this has
+         *              no effect
          *
-         * @param[in]   alwaysSetMode   For any non-zero value, the SPI modes
-         *                              will always be set before a read or
-         *                              write routine
+         * @param[in]   alwaysSetMode   Ignored
          */
         void always_set_spi_mode (const bool alwaysSetMode) {
-            this->m_alwaysSetMode = alwaysSetMode;
+            (void) alwaysSetMode;
         }
 
         /**
@@ -164,7 +164,7 @@ class L3G {
          * @return      Returns 0 upon success, error code otherwise
          */
         PropWare::ErrorCode read (const L3G::Axis axis, int16_t *val) const {
-            return this->read16(L3G::OUT_X_L + (axis << 1), val);
+            return this->read_words(L3G::OUT_X_L + (axis << 1), val, 1);
         }
 
         /**
@@ -175,7 +175,7 @@ class L3G {
          * @return      Returns 0 upon success, error code otherwise
          */
         PropWare::ErrorCode read_x (int16_t *val) const {
-            return this->read16(L3G::OUT_X_L, val);
+            return this->read_words(L3G::OUT_X_L, val, 1);
         }
 
         /**
@@ -186,7 +186,7 @@ class L3G {
          * @return      Returns 0 upon success, error code otherwise
          */
         PropWare::ErrorCode read_y (int16_t *val) const {
-            return this->read16(L3G::OUT_Y_L, val);
+            return this->read_words(L3G::OUT_Y_L, val, 1);
         }
 
         /**
@@ -197,7 +197,7 @@ class L3G {
          * @return      Returns 0 upon success, error code otherwise
          */
         PropWare::ErrorCode read_z (int16_t *val) const {
-            return this->read16(L3G::OUT_Z_L, val);
+            return this->read_words(L3G::OUT_Z_L, val, 1);
         }
 
         /**
@@ -210,37 +210,8 @@ class L3G {
          * @return      Returns 0 upon success, error code otherwise
          */
         PropWare::ErrorCode read_all (int16_t *val) const {
-            PropWare::ErrorCode err;
-            uint8_t i;
-
-            uint8_t addr = L3G::OUT_X_L;
-            addr |= BIT_7;  // Set RW bit (
-            addr |= BIT_6;  // Enable address auto-increment
-
-            check_errors(this->maybe_set_spi_mode());
-
-            this->m_cs.clear();
-            check_errors(this->m_spi->shift_out(8, addr));
-            check_errors(
-                    this->m_spi->shift_in(16, &(val[L3G::X]),
-                            sizeof(val[L3G::X])));
-            check_errors(
-                    this->m_spi->shift_in(16, &(val[L3G::Y]),
-                            sizeof(val[L3G::Y])));
-            check_errors(
-                    this->m_spi->shift_in(16, &(val[L3G::Z]),
-                            sizeof(val[L3G::Z])));
-            this->m_cs.set();
-
-            // err is useless at this point and will be used as a temporary
-            // 8-bit variable
-            for (i = 0; i < 3; ++i) {
-                err = (ErrorCode) (val[i] >> 8);
-                val[i] <<= 8;
-                val[i] |= err;
-            }
-
-            return 0;
+            // One transaction for all six registers
+            return this->read_words(L3G::OUT_X_L, val, 3);
         }
 
         /**
@@ -255,12 +226,11 @@ class L3G {
             uint8_t oldValue;
 
             this->m_dpsMode = dpsMode;
-            check_errors(this->maybe_set_spi_mode());
 
-            check_errors(this->read8(L3G::CTRL_REG4, (int8_t * ) &oldValue));
+            check_errors(this->read_register(L3G::CTRL_REG4, &oldValue));
             oldValue &= ~(BIT_5 | BIT_4);
             oldValue |= dpsMode;
-            check_errors(this->write8(L3G::CTRL_REG4, oldValue));
+            check_errors(this->write_register(L3G::CTRL_REG4, oldValue));
 
             return 0;
         }
@@ -319,144 +289,11 @@ class L3G {
 
     private:
         static const uint32_t SPI_DEFAULT_FREQ = 900000;
-        static const SPI::Mode SPI_MODE = SPI::MODE_3;
-        static const SPI::BitMode SPI_BITMODE = SPI::MSB_FIRST;
-
-    private:
-        /***********************************
-         *** Private Method Declarations ***
-         ***********************************/
-        /**
-         * @brief       Write one byte to the L3G module
-         *
-         * @param[in]   addr    Destination register address
-         * @param[in]   dat     Data to be written to the destination register
-         *
-         * @return      Returns 0 upon success, error code otherwise
-         */
-        PropWare::ErrorCode write8 (uint8_t addr, const uint8_t dat) const {
-            PropWare::ErrorCode err;
-            uint16_t outputValue;
-
-            addr &= ~BIT_7;  // Clear the RW bit (write mode)
-
-            outputValue = ((uint16_t) addr) << 8;
-            outputValue |= dat;
-
-            check_errors(this->maybe_set_spi_mode());
-
-            this->m_cs.clear();
-            check_errors(this->m_spi->shift_out(16, outputValue));
-            check_errors(this->m_spi->wait());
-            this->m_cs.set();
-
-            return err;
-        }
-
-        /**
-         * @brief       Write one byte to the L3G module
-         *
-         * @param[in]   addr    Destination register address
-         * @param[in]   dat     Data to be written to the destination register
-         *
-         * @return      Returns 0 upon success, error code otherwise
-         */
-        PropWare::ErrorCode write16 (uint8_t addr, const uint16_t dat) const {
-            PropWare::ErrorCode err;
-            uint16_t outputValue;
-
-            addr &= ~BIT_7;  // Clear the RW bit (write mode)
-            addr |= BIT_6;  // Enable address auto-increment
-
-            outputValue = ((uint16_t) addr) << 16;
-            outputValue |= ((uint16_t) ((uint8_t) dat)) << 8;
-            outputValue |= (uint8_t) (dat >> 8);
-
-            check_errors(this->maybe_set_spi_mode());
-
-            this->m_cs.clear();
-            check_errors(this->m_spi->shift_out(24, outputValue));
-            check_errors(this->m_spi->wait());
-            this->m_cs.set();
-
-            return 0;
-        }
-
-        /**
-         * @brief       Read one byte from the L3G module
-         *
-         * @param[in]   addr    Origin register address
-         * @param[out]  *dat    Address where incoming data should be stored
-         *
-         * @return      Returns 0 upon success, error code otherwise
-         */
-        PropWare::ErrorCode read8 (uint8_t addr, int8_t *dat) const {
-            PropWare::ErrorCode err;
-
-            addr |= BIT_7;  // Set RW bit (
-            addr |= BIT_6;  // Enable address auto-increment
-
-            check_errors(this->maybe_set_spi_mode());
-
-            this->m_cs.clear();
-            check_errors(this->m_spi->shift_out(8, addr));
-            check_errors(this->m_spi->shift_in(8, dat, sizeof(*dat)));
-            this->m_cs.set();
-
-            return 0;
-        }
-
-        /**
-         * @brief       Read two bytes from the L3G module
-         *
-         * @param[in]   addr    Origin register address
-         * @param[out]  *dat    Address where incoming data should be stored
-         *
-         * @return      Returns 0 upon success, error code otherwise
-         */
-        PropWare::ErrorCode read16 (uint8_t addr, int16_t *dat) const {
-            PropWare::ErrorCode err;
-
-            addr |= BIT_7;  // Set RW bit (
-            addr |= BIT_6;  // Enable address auto-increment
-
-            check_errors(this->maybe_set_spi_mode());
-
-            this->m_cs.clear();
-            check_errors(this->m_spi->shift_out(8, addr));
-            check_errors(this->m_spi->shift_in(16, dat, sizeof(*dat)));
-            this->m_cs.set();
-
-            // err is useless at this point and will be used as a temporary
-            // 8-bit variable
-            err = (ErrorCode) (*dat >> 8);
-            *dat <<= 8;
-            *dat |= err;
-
-            return 0;
-        }
-
-        /**
-         * @brief   Set the SPI mode iff PropWare::L3G::m_alwaysSetMode is true
-         *
-         * @return  Returns 0 upon success, error code otherwise
-         */
-        PropWare::ErrorCode maybe_set_spi_mode () const {
-            PropWare::ErrorCode err;
-
-            if (this->m_alwaysSetMode) {
-                check_errors(this->m_spi->set_mode(L3G::SPI_MODE));
-                check_errors(this->m_spi->set_bit_mode(L3G::SPI_BITMODE));
-            }
-
-            return 0;
-        }
+        static const SPIBus::Mode SPI_MODE = SPIBus::MODE_3;
+        static const SPIBus::BitMode SPI_BITMODE = SPIBus::MSB_FIRST;
 
     private:
-        SPI *m_spi;
-        PropWare::Pin m_cs;
         DPSMode m_dpsMode;
-        bool m_alwaysSetMode;
 };
 
 }
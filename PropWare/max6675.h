@@ -38,14 +38,15 @@ namespace PropWare {
 class MAX6675 {
     public:
         /**
-         * @brief       Construction requires an instance of the SPI module;
-         *              the SPI module does not need to be started
+         * @brief       Construction requires an SPI bus, either
+         *              PropWare::SPI or PropWare::InlineSPI; the bus does not
+         *              need to be started
          *
-         * @param[in]   *spi    Constructed SPI module
+         * @param[in]   *spi    Constructed SPI bus
          */
-        MAX6675 (SPI *spi) {
+        MAX6675 (SPIBus *spi) {
             this->m_spi = spi;
-            this->m_alwaysSetMode = 0;
+            this->m_profile = 0;
         }
 
         /**
@@ -70,32 +71,29 @@ class MAX6675 {
                                 PropWare::MAX6675::SPI_DEFAULT_FREQ,
                                 PropWare::MAX6675::SPI_MODE,
                                 PropWare::MAX6675::SPI_BITMODE));
-            } else {
-                check_errors(
-                        this->m_spi->set_mode(PropWare::MAX6675::SPI_MODE));
-                check_errors(
-                        this->m_spi->set_bit_mode(
-                                PropWare::MAX6675::SPI_BITMODE));
             }
 
-            this->m_cs.set_mask(cs);
-            this->m_cs.set_dir(PropWare::Pin::OUT);
-            this->m_cs.set();
+            // The SPI cog applies these settings and drives chip select on
+            // every read
+            check_errors(
+                    this->m_spi->add_profile(cs, PropWare::MAX6675::SPI_MODE,
+                            PropWare::MAX6675::SPI_BITMODE,
+                            PropWare::MAX6675::SPI_DEFAULT_FREQ,
+                            &this->m_profile));
 
             return 0;
         }
 
         /**
-         * @brief       Choose whether to always set the SPI mode and bitmode
-         *              before reading or writing to the chip; Useful when
-         *              multiple devices are connected to the SPI bus
+         * @brief       Retained for compatibility; The SPI mode and bitmode are
+         *              now applied by the SPI cog whenever the chip is selected
+         *              (see PropWare::SPI::add_profile()), so this has no
+         *              effect
          *
-         * @param[in]   alwaysSetMode   For any non-zero value, the SPI modes
-         *                              will always be set before a read or
-         *                              write routine
+         * @param[in]   alwaysSetMode   Ignored
          */
         void always_set_spi_mode (const bool alwaysSetMode) {
-            this->m_alwaysSetMode = alwaysSetMode;
+            (void) alwaysSetMode;
         }
 
         /**
@@ -111,22 +109,14 @@ class MAX6675 {
         PropWare::ErrorCode read (uint16_t *dat) {
             PropWare::ErrorCode err;
 
-            if (this->m_alwaysSetMode) {
-                check_errors(
-                        this->m_spi->set_mode(PropWare::MAX6675::SPI_MODE));
-                check_errors(
-                        this->m_spi->set_bit_mode(
-                                PropWare::MAX6675::SPI_BITMODE));
-            }
-
             *dat = 0;
-            this->m_cs.clear();
-            check_errors(
-                    this->m_spi->shift_in(MAX6675::BIT_WIDTH, dat,
-                            sizeof(*dat)));
-            this->m_cs.set();
+            check_errors(this->m_spi->select(this->m_profile));
 
-            return 0;
+            // Chip select and the bus are released even upon an error
+            err = this->m_spi->shift_in(MAX6675::BIT_WIDTH, dat, sizeof(*dat));
+            this->m_spi->deselect(this->m_profile);
+
+            return err;
         }
 
         /**
@@ -166,14 +156,13 @@ class MAX6675 {
 
     private:
         static const uint32_t SPI_DEFAULT_FREQ = 1000000;
-        static const SPI::Mode SPI_MODE = SPI::MODE_1;
-        static const SPI::BitMode SPI_BITMODE = SPI::MSB_FIRST;
+        static const SPIBus::Mode SPI_MODE = SPIBus::MODE_1;
+        static const SPIBus::BitMode SPI_BITMODE = SPIBus::MSB_FIRST;
         static const uint8_t BIT_WIDTH = 12;
 
     private:
-        SPI *m_spi;
-        PropWare::Pin m_cs;
-        bool m_alwaysSetMode;
+        SPIBus *m_spi;
+        SPIBus::ProfileId m_profile;
 };
 
 }
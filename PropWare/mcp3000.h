@@ -73,15 +73,16 @@ class MCP3000 {
 
     public:
         /**
-         * @brief       Construction requires an instance of the SPI module;
-         *              the SPI module does not need to be started
+         * @brief       Construction requires an SPI bus, either
+         *              PropWare::SPI or PropWare::InlineSPI; the bus does not
+         *              need to be started
          *
-         * @param[in]   *spi    Constructed SPI module
+         * @param[in]   *spi    Constructed SPI bus
          * @param[in]   partNumber  Determine bit-width of the ADC channels
          */
-        MCP3000 (SPI *spi, MCP3000::PartNumber partNumber) {
+        MCP3000 (SPIBus *spi, MCP3000::PartNumber partNumber) {
             this->m_spi = spi;
-            this->m_alwaysSetMode = 0;
+            this->m_profile = 0;
             this->m_dataWidth = partNumber;
         }
 
@@ -100,38 +101,35 @@ class MCP3000 {
                 const PropWare::Pin::Mask cs) {
             PropWare::ErrorCode err;
 
-            this->m_cs.set_mask(cs);
-            this->m_cs.set_dir(PropWare::Pin::OUT);
-            this->m_cs.set();
-
             if (!this->m_spi->is_running()) {
                 check_errors(
                         this->m_spi->start(mosi, miso, sclk,
                                 PropWare::MCP3000::SPI_DEFAULT_FREQ,
                                 PropWare::MCP3000::SPI_MODE,
                                 PropWare::MCP3000::SPI_BITMODE));
-            } else {
-                check_errors(
-                        this->m_spi->set_mode(PropWare::MCP3000::SPI_MODE));
-                check_errors(
-                        this->m_spi->set_bit_mode(
-                                PropWare::MCP3000::SPI_BITMODE));
             }
 
+            // The SPI cog applies these settings and drives chip select on
+            // every read
+            check_errors(
+                    this->m_spi->add_profile(cs, PropWare::MCP3000::SPI_MODE,
+                            PropWare::MCP3000::SPI_BITMODE,
+                            PropWare::MCP3000::SPI_DEFAULT_FREQ,
+                            &this->m_profile));
+
             return 0;
         }
 
         /**
-         * @brief       Choose whether to always set the SPI mode and bitmode
-         *              before reading or writing to the ADC; Useful when
-         *              multiple devices are connected to the SPI bus
+         * @brief       Retained for compatibility; The SPI mode and bitmode are
+         *              now applied by the SPI cog whenever the ADC is selected
+         *              (see PropWare::SPI::add_profile()), so this has no
+         *              effect
          *
-         * @param[in]   alwaysSetMode   For any non-zero value, the SPI modes
-         *                              will always be set before a read or
-         *                              write routine
+         * @param[in]   alwaysSetMode   Ignored
          */
         void always_set_spi_mode (const bool alwaysSetMode) {
-            this->m_alwaysSetMode = alwaysSetMode;
+            (void) alwaysSetMode;
         }
 
         /**
@@ -155,21 +153,13 @@ class MCP3000 {
             // Two dead bits between output and input - see page 19 of datasheet
             options <<= 2;
 
-            if (this->m_alwaysSetMode) {
-                check_errors(this->m_spi->set_mode(MCP3000::SPI_MODE));
-                check_errors(this->m_spi->set_bit_mode(MCP3000::SPI_BITMODE));
-            }
+            check_errors(this->m_spi->select(this->m_profile));
 
-            this->m_cs.clear();
-            check_errors(
-                    this->m_spi->shift_out(PropWare::MCP3000::OPTN_WIDTH,
-                            (uint32_t) options));
-            check_errors(
-                    this->m_spi->shift_in(this->m_dataWidth, dat,
-                            sizeof(*dat)));
-            this->m_cs.set();
+            // Chip select and the bus are released even upon an error
+            err = this->exchange((uint8_t) options, dat);
+            this->m_spi->deselect(this->m_profile);
 
-            return 0;
+            return err;
         }
 
         /**
@@ -194,30 +184,144 @@ class MCP3000 {
             // Two dead bits between output and input - see page 19 of datasheet
             options <<= 2;
 
-            if (this->m_alwaysSetMode) {
-                check_errors(
-                        this->m_spi->set_mode(PropWare::MCP3000::SPI_MODE));
-                check_errors(
-                        this->m_spi->set_bit_mode(
-                                PropWare::MCP3000::SPI_BITMODE));
-            }
+            check_errors(this->m_spi->select(this->m_profile));
+
+            // Chip select and the bus are released even upon an error
+            err = this->exchange((uint8_t) options, dat);
+            this->m_spi->deselect(this->m_profile);
+
+            return err;
+        }
+
+        /**
+         * @brief       Read the same channel of several ADCs at once in
+         *              single-ended mode
+         *
+         * Every ADC shares MOSI, SCLK and this ADC's chip select, and drives
+         * its own MISO pin, so all of them sample the channel at the same
+         * instant. The ADCs must be the same part number as this one
+         *
+         * @param[in]       channel     One of MCP_CHANNEL_<x>; Selects the
+         *                              channel to be read on every ADC
+         * @param[in,out]   adcs[]      MISO pin mask of each ADC; Each ADC's
+         *                              conversion result is stored alongside
+         *                              its mask
+         * @param[in]       count       Number of ADCs
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode read_gang (const MCP3000::Channel channel,
+                SPIBus::GangChannel adcs[], const uint8_t count) {
+            PropWare::ErrorCode err;
+            int8_t options;
+
+            options = PropWare::MCP3000::START | PropWare::MCP3000::SINGLE_ENDED
+                    | channel;
+            options <<= 2;
+
+            check_errors(this->m_spi->select(this->m_profile));
+
+            // Chip select and the bus are released even upon an error
+            err = this->gang_exchange((uint8_t) options, adcs, count);
+            this->m_spi->deselect(this->m_profile);
+
+            return err;
+        }
+
+        /**
+         * @brief       Read the same channel pair of several ADCs at once in
+         *              differential mode; See MCP3000::read_gang()
+         *
+         * @param[in]       channels    One of DIFF_<x>_<y>; Selects the channel
+         *                              pair to be read on every ADC
+         * @param[in,out]   adcs[]      MISO pin mask of each ADC; Each ADC's
+         *                              conversion result is stored alongside
+         *                              its mask
+         * @param[in]       count       Number of ADCs
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode read_gang_diff (const MCP3000::ChannelDiff channels,
+                SPIBus::GangChannel adcs[], const uint8_t count) {
+            PropWare::ErrorCode err;
+            int8_t options;
+
+            options = PropWare::MCP3000::START | PropWare::MCP3000::DIFFERENTIAL
+                    | channels;
+            options <<= 2;
+
+            check_errors(this->m_spi->select(this->m_profile));
+
+            // Chip select and the bus are released even upon an error
+            err = this->gang_exchange((uint8_t) options, adcs, count);
+            this->m_spi->deselect(this->m_profile);
+
+            return err;
+        }
+
+    private:
+        /**
+         * @brief       Shift out the command and shift in the conversion result
+         *
+         * The null bit is shifted in ahead of the result, so it reads as a
+         * leading zero
+         *
+         * @param[in]   options     Command bits, including the two dead bits
+         * @param[out]  *dat        Address that data should be placed into
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode exchange (const uint8_t options, uint16_t *dat) {
+            PropWare::ErrorCode err;
 
-            this->m_cs.clear();
             check_errors(
                     this->m_spi->shift_out(PropWare::MCP3000::OPTN_WIDTH,
                             (uint32_t) options));
             check_errors(
                     this->m_spi->shift_in(this->m_dataWidth, dat,
                             sizeof(*dat)));
-            this->m_cs.set();
+
+            return 0;
+        }
+
+        /**
+         * @brief       Like MCP3000::exchange(), but for every ADC of a gang
+         *
+         * The gang is clocked by a single full-duplex transfer, which samples
+         * MISO ahead of the trailing edge rather than the leading edge: the
+         * first bit of the result is already present on the final clock of
+         * the command, so one clock fewer is needed than in
+         * MCP3000::exchange(). This timing has been checked against the host
+         * emulator's model only
+         *
+         * @param[in]       options     Command bits, including the two dead
+         *                              bits
+         * @param[in,out]   adcs[]      MISO pin mask of each ADC; Each ADC's
+         *                              conversion result is stored alongside
+         *                              its mask
+         * @param[in]       count       Number of ADCs
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode gang_exchange (const uint8_t options,
+                SPIBus::GangChannel adcs[], const uint8_t count) {
+            PropWare::ErrorCode err;
+            const uint8_t resultWidth = this->m_dataWidth - 1;
+
+            check_errors(
+                    this->m_spi->gang_transfer(
+                            PropWare::MCP3000::OPTN_WIDTH + resultWidth,
+                            ((uint32_t) options) << resultWidth, adcs, count));
+            for (uint8_t i = 0; i < count; ++i)
+                adcs[i].data &= (1 << this->m_dataWidth) - 1;
 
             return 0;
         }
 
     private:
         static const uint32_t SPI_DEFAULT_FREQ = 100000;
-        static const SPI::Mode SPI_MODE = SPI::MODE_2;
-        static const SPI::BitMode SPI_BITMODE = SPI::MSB_FIRST;
+        static const SPIBus::Mode SPI_MODE = SPIBus::MODE_2;
+        static const SPIBus::BitMode SPI_BITMODE = SPIBus::MSB_FIRST;
 
         static const uint8_t START = BIT_4;
         static const uint8_t SINGLE_ENDED = BIT_3;
@@ -225,9 +329,8 @@ class MCP3000 {
         static const uint8_t OPTN_WIDTH = 7;
 
     private:
-        SPI *m_spi;
-        PropWare::Pin m_cs;
-        bool m_alwaysSetMode;
+        SPIBus *m_spi;
+        SPIBus::ProfileId m_profile;
         uint8_t m_dataWidth;
 };
 
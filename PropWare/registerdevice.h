@@ -0,0 +1,264 @@
+/**
+ * @file        registerdevice.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_REGISTERDEVICE_H_
+#define PROPWARE_REGISTERDEVICE_H_
+
+#include <PropWare/PropWare.h>
+#include <PropWare/spibus.h>
+#include <PropWare/spi.h>
+
+namespace PropWare {
+
+/**
+ * @brief       Base for drivers of SPI devices whose registers are addressed by
+ *              the first byte of each transaction, as most accelerometers,
+ *              gyroscopes and magnetometers are
+ *
+ * Any number of consecutive registers are read or written in one transaction:
+ * the address byte is followed by a single block transfer. Multi-byte
+ * registers are converted between the device's byte order and the Propeller's
+ * (least significant byte first) as they are read or written; The conversion
+ * is chosen at compile time and costs nothing for devices that already store
+ * the least significant byte first.
+ *
+ * A derived class registers its device with SPIBus::add_profile(), storing
+ * the result in RegisterDevice::m_profile:
+ *
+ *     class L3G: public PropWare::RegisterDevice<BIT_7, BIT_6, false> { ... };
+ *
+ * @tparam  READ_BIT        Set in the address byte to read; Cleared to write
+ * @tparam  INCREMENT_BIT   Set in the address byte to step through consecutive
+ *                          registers; Zero if the device always does
+ * @tparam  HIGH_BYTE_FIRST True if the most significant byte of a multi-byte
+ *                          register is found at the lowest address
+ */
+template<uint8_t READ_BIT, uint8_t INCREMENT_BIT, bool HIGH_BYTE_FIRST>
+class RegisterDevice {
+    public:
+        /** Largest number of bytes written by RegisterDevice::write_words() */
+        static const uint8_t MAX_WRITE_BURST = 32;
+
+    public:
+        /**
+         * @param[in]   *spi    Constructed SPI bus; It does not need to be
+         *                      started
+         */
+        RegisterDevice (SPIBus *spi) {
+            this->m_spi = spi;
+            this->m_profile = 0;
+        }
+
+        /**
+         * @brief       Read consecutive registers in one transaction
+         *
+         * @param[in]   firstRegister   Address of the first register
+         * @param[out]  data[]          Register contents, in address order
+         * @param[in]   count           Number of registers
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode read_registers (const uint8_t firstRegister,
+                uint8_t data[], const size_t count) const {
+            PropWare::ErrorCode err;
+
+            check_errors(this->m_spi->select(this->m_profile));
+
+            // Chip select and the bus are released even upon an error
+            err = this->m_spi->shift_out(8,
+                    RegisterDevice::address(firstRegister, count) | READ_BIT);
+            if (!err)
+                err = this->m_spi->shift_in_block(data, count);
+            this->m_spi->deselect(this->m_profile);
+
+            return err;
+        }
+
+        /**
+         * @brief       Write consecutive registers in one transaction
+         *
+         * @param[in]   firstRegister   Address of the first register
+         * @param[in]   data[]          Register contents, in address order
+         * @param[in]   count           Number of registers
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode write_registers (const uint8_t firstRegister,
+                const uint8_t data[], const size_t count) const {
+            PropWare::ErrorCode err;
+
+            check_errors(this->m_spi->select(this->m_profile));
+
+            // Chip select and the bus are released even upon an error
+            err = this->m_spi->shift_out(8,
+                    RegisterDevice::address(firstRegister, count));
+            if (!err)
+                err = this->m_spi->shift_out_block(data, count);
+            this->m_spi->deselect(this->m_profile);
+
+            return err;
+        }
+
+        /**
+         * @brief       Read a single register
+         *
+         * @param[in]   reg     Register address
+         * @param[out]  *data   Register contents
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode read_register (const uint8_t reg,
+                uint8_t *data) const {
+            return this->read_registers(reg, data, 1);
+        }
+
+        /**
+         * @brief       Write a single register
+         *
+         * @param[in]   reg     Register address
+         * @param[in]   data    Register contents
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode write_register (const uint8_t reg,
+                const uint8_t data) const {
+            return this->write_registers(reg, &data, 1);
+        }
+
+        /**
+         * @brief       Read consecutive multi-byte registers, such as the axes
+         *              of a sensor, in one transaction
+         *
+         * @tparam      T               Type of each register, such as int16_t
+         *
+         * @param[in]   firstRegister   Address of the first byte of the first
+         *                              word
+         * @param[out]  words[]         Register contents, in address order
+         * @param[in]   count           Number of words
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        template<typename T>
+        PropWare::ErrorCode read_words (const uint8_t firstRegister,
+                T words[], const size_t count) const {
+            PropWare::ErrorCode err;
+
+            check_errors(
+                    this->read_registers(firstRegister, (uint8_t *) words,
+                            count * sizeof(T)));
+            RegisterDevice::swap_words((uint8_t *) words, sizeof(T), count);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Write consecutive multi-byte registers in one
+         *              transaction
+         *
+         * @tparam      T               Type of each register, such as int16_t
+         *
+         * @param[in]   firstRegister   Address of the first byte of the first
+         *                              word
+         * @param[in]   words[]         Register contents, in address order
+         * @param[in]   count           Number of words; No more than
+         *                              MAX_WRITE_BURST bytes may be written
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        template<typename T>
+        PropWare::ErrorCode write_words (const uint8_t firstRegister,
+                const T words[], const size_t count) const {
+            uint8_t buffer[RegisterDevice::MAX_WRITE_BURST];
+            const size_t length = count * sizeof(T);
+
+            if (!HIGH_BYTE_FIRST)
+                return this->write_registers(firstRegister,
+                        (const uint8_t *) words, length);
+
+            if (RegisterDevice::MAX_WRITE_BURST < length)
+                return SPI::EXCESSIVE_PAR_SZ;
+            memcpy(buffer, words, length);
+            RegisterDevice::swap_words(buffer, sizeof(T), count);
+            return this->write_registers(firstRegister, buffer, length);
+        }
+
+        /**
+         * @brief       Read consecutive registers straight into a struct
+         *
+         * @tparam      T               Type of every member of the struct,
+         *                              such as int16_t; Members must be
+         *                              declared in register order
+         * @tparam      S               Type of the struct
+         *
+         * @param[in]   firstRegister   Address of the register mapped to the
+         *                              first member
+         * @param[out]  *registers      Struct to be filled
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        template<typename T, typename S>
+        PropWare::ErrorCode read_struct (const uint8_t firstRegister,
+                S *registers) const {
+            return this->read_words(firstRegister, (T *) registers,
+                    sizeof(S) / sizeof(T));
+        }
+
+    protected:
+        /**
+         * @brief   Address byte for a transfer of count registers
+         */
+        static uint8_t address (const uint8_t firstRegister,
+                const size_t count) {
+            if (1 < count)
+                return (firstRegister | INCREMENT_BIT) & ~READ_BIT;
+            else
+                return firstRegister & ~READ_BIT;
+        }
+
+        /**
+         * @brief   Convert words between the device's byte order and the
+         *          Propeller's; Compiled out entirely when they match
+         */
+        static void swap_words (uint8_t bytes[], const size_t size,
+                const size_t count) {
+            if (!HIGH_BYTE_FIRST || 1 == size)
+                return;
+
+            for (size_t word = 0; word < count; ++word, bytes += size)
+                for (size_t i = 0; i < size / 2; ++i) {
+                    const uint8_t temp = bytes[i];
+                    bytes[i] = bytes[size - 1 - i];
+                    bytes[size - 1 - i] = temp;
+                }
+        }
+
+    protected:
+        SPIBus *m_spi;
+        SPIBus::ProfileId m_profile;
+};
+
+}
+
+#endif /* PROPWARE_REGISTERDEVICE_H_ */
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <PropWare/PropWare.h>
 #include <PropWare/spi.h>
+#include <PropWare/sdbus.h>
 #include <PropWare/pin.h>
 
 // Rather than include all of stdio.h, only these definitions will be declared
@@ -84,6 +85,14 @@ namespace PropWare {
  *          RAM usage
  */
 #define SD_OPTION_FILE_WRITE
+/**
+ * Enable CRC checking by the card (CMD59) once it is initialized, so that
+ * corrupted commands and sectors written to the card are rejected instead of
+ * being silently accepted; Sectors read from the card are always checked
+ * <p>
+ * DEFAULT: On
+ */
+#define SD_OPTION_CRC
 /** @} */
 
 /**
@@ -93,6 +102,15 @@ namespace PropWare {
  *          SD v1 cards will throw an error at SD::start(); non-FAT partitions
  *          will yield unknown results
  *
+ * The card is reached either through a PropWare::SPI module or, four times as
+ * wide, through a PropWare::SDBus on the card's native bus:
+ *
+ *     PropWare::SDBus bus;
+ *     PropWare::SD sd(&bus);
+ *     sd.start(CLK, CMD, DAT0, 0);
+ *
+ * Everything above SD::start() is the same for both.
+ *
  * TODO:    Re-arrange errors in order of impact level; Allows the user to do
  *          something like:
  *              if ((SD_ERRORS_BASE + 6) < (err = SDFoo()))
@@ -112,6 +130,8 @@ class SD {
         static const uint16_t SECTOR_SIZE = SD_SECTOR_SIZE;
         /** Default frequency to run the SPI module */
         static const uint32_t DEFAULT_SPI_FREQ = 900000;
+        /** Default frequency of the native bus outside of data blocks */
+        static const uint32_t DEFAULT_BUS_FREQ = 25000000;
 
         // Signal that the contents of a buffer are a directory
         static const int8_t FOLDER_ID = -1;
@@ -224,7 +244,8 @@ class SD {
             /** SD Error 18 */FILE_WITHOUT_BUFFER,
             /** SD Error 19 */INVALID_FILESYSTEM,
             /** SD Error 20 */CMD8_FAILURE,
-            /** End system errors */END_SYS_ERROR = PropWare::SD::CMD8_FAILURE,
+            /** SD Error 21 */CRC_FAILURE,
+            /** End system errors */END_SYS_ERROR = PropWare::SD::CRC_FAILURE,
             /** Last SD error code */END_ERROR = PropWare::SD::END_SYS_ERROR
         } ErrorCode;
 
@@ -304,6 +325,21 @@ class SD {
          */
         SD (SPI *spi) {
             this->m_spi = spi;
+            this->m_bus = NULL;
+            this->m_profile = 0;
+            this->m_fileID = 0;
+#ifdef SD_OPTION_FILE_WRITE
+            this->m_fatMod = false;
+#endif
+        }
+
+        /**
+         * @brief       Construct an SD object for a card on the native bus
+         */
+        SD (SDBus *bus) {
+            this->m_spi = NULL;
+            this->m_bus = bus;
+            this->m_profile = 0;
             this->m_fileID = 0;
 #ifdef SD_OPTION_FILE_WRITE
             this->m_fatMod = false;
@@ -326,7 +362,8 @@ class SD {
          *
          * Starts an SPI cog IFF an SPI cog has not already been started; If
          * one has been started, only the cs and freq parameter will have
-         * effect
+         * effect. Fails with SD::INVALID_INIT if the SD object was constructed
+         * with an SDBus
          *
          * @param[in]   mosi        PinNum mask for MOSI pin
          * @param[in]   miso        PinNum mask for MISO pin
@@ -344,6 +381,11 @@ class SD {
                 const int32_t freq) {
             PropWare::ErrorCode err;
             uint8_t response[16];
+            const int32_t frequency =
+                    (-1 == freq || 0 == freq) ? SD::DEFAULT_SPI_FREQ : freq;
+
+            if (NULL == this->m_spi)
+                return SD::INVALID_INIT;
 
             // Set CS for output and initialize high
             this->m_cs.set_mask(cs);
@@ -355,25 +397,138 @@ class SD {
                     SD::SPI_MODE, SD::SPI_BITMODE)))
                 return err;
 
-            // Try and get the card up and responding to commands first
-            check_errors(this->reset_and_verify_v2_0(response));
-
-            check_errors(this->send_active(response));
+            // Chip select is driven by this cog until initialization is
+            // complete, so no other cog may use the bus in the meantime
+            this->m_spi->lock();
 
-            check_errors(this->increase_throttle(freq));
+            // Try and get the card up and responding to commands first
+            err = this->reset_and_verify_v2_0(response);
+            if (!err)
+                err = this->send_active();
+#ifdef SD_OPTION_CRC
+            if (!err)
+                err = this->enable_crc();
+#endif
+            if (!err)
+                err = this->increase_throttle(frequency);
 
 #ifdef SD_OPTION_VERBOSE
-            check_errors(this->print_init_debug_blocks(response));
+            if (!err)
+                err = this->print_init_debug_blocks(response);
 #endif
 
             // We're finally done initializing everything. Set chip select high
             // again to release the SPI port
+            if (!err)
+                err = this->m_spi->fence();
             this->m_cs.set();
+            this->m_spi->unlock();
+
+            if (err)
+                return err;
+
+            // Hand chip select over to the SPI cog, which applies the card's
+            // settings and drives chip select for every block access. This cog
+            // stops driving the pin only once the SPI cog holds it high
+            if (0 == this->m_profile)
+                check_errors(
+                        this->m_spi->add_profile(cs, SD::SPI_MODE,
+                                SD::SPI_BITMODE, frequency, &this->m_profile));
+            check_errors(this->m_spi->fence());
+            this->m_cs.set_dir(PropWare::Pin::IN);
 
             // Initialization complete
             return 0;
         }
 
+        /**
+         * @brief       Initialize SD card communication over the native bus;
+         *              The SD object must have been constructed with an SDBus,
+         *              whose cog is started here
+         *
+         * @param[in]   clk     PinNum mask for CLK pin
+         * @param[in]   cmd     PinNum mask for CMD pin
+         * @param[in]   dat0    PinNum mask for DAT0 pin; DAT1-DAT3 must be the
+         *                      three pins above it
+         * @param[in]   freq    Frequency to run CLK outside of data blocks
+         *                      after initialization; if -1 or 0 is passed in,
+         *                      a system default will be used
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode start (const PropWare::Port::Mask clk,
+                const PropWare::Port::Mask cmd,
+                const PropWare::Port::Mask dat0, const int32_t freq) {
+            PropWare::ErrorCode err;
+            uint32_t response;
+            uint32_t timeout;
+            uint32_t longWiggleRoom = (uint32_t) (3 * MILLISECOND);
+            const int32_t frequency =
+                    (-1 == freq || 0 == freq) ? SD::DEFAULT_BUS_FREQ : freq;
+
+            if (NULL == this->m_bus)
+                return SD::INVALID_INIT;
+
+            // The bus cog sends the card its first clocks as it starts
+            waitcnt(CLKFREQ / 10 + CNT);
+            check_errors(
+                    this->m_bus->start(clk, cmd, dat0, SD::SPI_INIT_FREQ));
+
+            // Reset the card and make sure it is v2.0 or later; Nothing answers
+            // CMD0 on the native bus
+            check_errors(
+                    this->send_bus_command(SD::CMD_IDLE, 0,
+                            SD::BUS_NO_RESPONSE));
+            check_errors(
+                    this->send_bus_command(SD::CMD_INTERFACE_COND,
+                            SD::ARG_CMD8, SD::BUS_R7, &response));
+            if (SD::ARG_CMD8 != (response & SD::ARG_CMD8_BITS))
+                return SD::CMD8_FAILURE;
+
+            // Unlike SPI mode, the card must be given a voltage window before
+            // it will power up
+            timeout = SD::SEND_ACTIVE_TIMEOUT + CNT;
+            do {
+                check_errors(
+                        this->send_bus_command(SD::CMD_APP, 0, SD::BUS_R1));
+                check_errors(
+                        this->send_bus_command(SD::CMD_WR_OP,
+                                SD::ARG_BUS_WR_OP, SD::BUS_R3, &response));
+
+                if (abs(timeout - CNT) < longWiggleRoom)
+                    return SD::READ_TIMEOUT;
+            } while (!(SD::OCR_POWERED_UP & response));
+
+            // Take the card out of identification mode: it gives up its CID,
+            // is assigned a relative address and is then selected with it
+            check_errors(
+                    this->send_bus_command(SD::CMD_ALL_SEND_CID, 0,
+                            SD::BUS_R2));
+            check_errors(
+                    this->send_bus_command(SD::CMD_SEND_RCA, 0, SD::BUS_R6,
+                            &response));
+            this->m_rca = response & SD::RCA_BITS;
+            check_errors(
+                    this->send_bus_command(SD::CMD_SELECT, this->m_rca,
+                            SD::BUS_R1));
+
+            // Full speed and all four data lines from here on
+            check_errors(this->m_bus->set_clock(frequency));
+            check_errors(
+                    this->send_bus_command(SD::CMD_APP, this->m_rca,
+                            SD::BUS_R1));
+            check_errors(
+                    this->send_bus_command(SD::CMD_SET_BUS_WIDTH,
+                            SD::ARG_BUS_WIDTH_4, SD::BUS_R1));
+
+#ifdef SD_OPTION_VERBOSE
+            printf("Native bus ready; Relative card address 0x%04x\n",
+                    this->m_rca >> 16);
+#endif
+
+            return 0;
+        }
+
         /**
          * @brief   Mount either FAT16 or FAT32 file system
          *
@@ -909,6 +1064,54 @@ class SD {
             return (0 < count) ? s : NULL;
         }
 
+        /**
+         * @brief       Read a block of bytes from a file, a sector at a time
+         *              rather than a character at a time
+         *
+         * Reading stops early at the end of the file. Bytes are copied straight
+         * out of the file's buffer, so the cost of a sector that is read whole
+         * is one sector load and one memcpy()
+         *
+         * @pre         *f must point to a currently opened and valid file
+         *
+         * @param[in]   *f          Address with the currently opened file
+         * @param[out]  buf[]       Array to store file bytes
+         * @param[in]   length      Maximum number of bytes to read
+         * @param[out]  *count      Number of bytes read
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode fread (SD::File *f, uint8_t buf[],
+                uint32_t length, uint32_t *count) {
+            PropWare::ErrorCode err;
+
+            *count = 0;
+            if (f->length - f->rPtr < length)
+                length = f->length - f->rPtr;
+
+            while (*count < length) {
+                const uint16_t ptr = (uint16_t) (f->rPtr % SD::SECTOR_SIZE);
+                const uint32_t sectorOffset = f->rPtr >> SD::SECTOR_SIZE_SHIFT;
+                uint32_t chunk = SD::SECTOR_SIZE - ptr;
+
+                // Determine if the correct sector is loaded
+                if (f->buf->id != f->id) {
+                    check_errors(this->reload_buf(f));
+                } else if (sectorOffset != f->curSector) {
+                    check_errors(this->load_sector_from_offset(f,
+                            sectorOffset));
+                }
+
+                if (length - *count < chunk)
+                    chunk = length - *count;
+                memcpy(&buf[*count], &f->buf->buf[ptr], chunk);
+                f->rPtr += chunk;
+                *count += chunk;
+            }
+
+            return 0;
+        }
+
         /**
          * @brief       Determine whether the read pointer has reached the end
          *              of the file
@@ -1403,6 +1606,10 @@ class SD {
                                     "does not support the 3.3V I/O used by "
                                     "the Propeller");
                     break;
+                case SD::CRC_FAILURE:
+                    printf(str, relativeError, "Data block failed its CRC "
+                            "check");
+                    break;
                 case SD::READING_PAST_EOC:
                     printf(str, relativeError, "Reading past the"
                             " end-of-chain marker");
@@ -1449,7 +1656,7 @@ class SD {
                 for (j = 0; j < 10 && !stageCleared; ++j) {
                     check_errors(this->power_up());
 
-                    check_errors(this->reset(response, &stageCleared));
+                    check_errors(this->reset(&stageCleared));
                 }
 
                 // If we couldn't go idle after 10 tries, give up
@@ -1486,7 +1693,7 @@ class SD {
 
             // Be very super 100% sure that all clocks have finished ticking
             // before setting chip select low
-            check_errors(this->m_spi->wait());
+            check_errors(this->m_spi->fence());
             waitcnt(10*MILLISECOND + CNT);
 
             // Chip select goes low for the duration of this function
@@ -1495,13 +1702,14 @@ class SD {
             return 0;
         }
 
-        inline PropWare::ErrorCode reset (uint8_t response[], bool *isIdle) {
+        inline PropWare::ErrorCode reset (bool *isIdle) {
             PropWare::ErrorCode err;
 
             // Send SD into idle state, retrieve a response and ensure it is the
-            // "idle" response
-            check_errors(this->send_command(SD::CMD_IDLE, 0, SD::CRC_IDLE));
-            this->get_response(SD::RESPONSE_LEN_R1, response);
+            // "idle" response; A card that does not answer yet is tried again
+            err = this->send_command(SD::CMD_IDLE, 0, SD::RESPONSE_LEN_R1);
+            if (err && SD::BEG_ERROR > err)
+                return err;
 
             // Check if idle
             if (SD::RESPONSE_IDLE == this->m_firstByteResponse)
@@ -1526,8 +1734,7 @@ class SD {
             // Inform SD card that the Propeller uses the 2.7-3.6V range;
             check_errors(
                     this->send_command(SD::CMD_INTERFACE_COND, SD::ARG_CMD8,
-                            SD::CRC_CMD8));
-            check_errors(this->get_response(SD::RESPONSE_LEN_R7, response));
+                            SD::RESPONSE_LEN_R7, response));
             if (SD::RESPONSE_IDLE == this->m_firstByteResponse)
                 *stageCleared = true;
 
@@ -1541,7 +1748,7 @@ class SD {
             return 0;
         }
 
-        inline PropWare::ErrorCode send_active (uint8_t response[]) {
+        inline PropWare::ErrorCode send_active () {
             PropWare::ErrorCode err;
             uint32_t timeout;
             uint32_t longWiggleRoom = (uint32_t) (3 * MILLISECOND);
@@ -1552,12 +1759,13 @@ class SD {
             do {
                 // Send the application-specific pre-command
                 check_errors(
-                        this->send_command(SD::CMD_APP, 0, SD::CRC_ACMD_PREP));
-                check_errors(this->get_response(SD::RESPONSE_LEN_R1, response));
+                        this->send_command(SD::CMD_APP, 0,
+                                SD::RESPONSE_LEN_R1));
 
                 // Request that the SD card go active!
-                check_errors(this->send_command(SD::CMD_WR_OP, BIT_30, 0));
-                check_errors(this->get_response(SD::RESPONSE_LEN_R1, response));
+                check_errors(
+                        this->send_command(SD::CMD_WR_OP, BIT_30,
+                                SD::RESPONSE_LEN_R1));
 
                 // If the card ACKed with the active state, we're all good!
                 if (SD::RESPONSE_ACTIVE == this->m_firstByteResponse)
@@ -1578,6 +1786,24 @@ class SD {
             return 0;
         }
 
+#ifdef SD_OPTION_CRC
+        inline PropWare::ErrorCode enable_crc () {
+            PropWare::ErrorCode err;
+
+            check_errors(
+                    this->send_command(SD::CMD_CRC_ON_OFF, SD::ARG_CRC_ON,
+                            SD::RESPONSE_LEN_R1));
+            if (SD::RESPONSE_ACTIVE != this->m_firstByteResponse)
+                return SD::INVALID_RESPONSE;
+
+#ifdef SD_OPTION_VERBOSE
+            printf("CRC checking enabled\n");
+#endif
+
+            return 0;
+        }
+#endif
+
         inline PropWare::ErrorCode increase_throttle (const int32_t freq) {
             PropWare::ErrorCode err;
 
@@ -1808,24 +2034,26 @@ class SD {
 
             // Request operating conditions register and ensure response begins
             // with R1
-            check_errors(this->send_command(SD::CMD_READ_OCR, 0,
-                            SD::CRC_OTHER));
-            check_errors(this->get_response(SD::RESPONSE_LEN_R3, response));
+            check_errors(
+                    this->send_command(SD::CMD_READ_OCR, 0, SD::RESPONSE_LEN_R3,
+                            response));
             printf("Operating Conditions Register (OCR)...\n");
             this->print_hex_block(response, SD::RESPONSE_LEN_R3);
 
             // If debugging requested, print to the screen CSD and CID registers
             // from SD card
             printf("Requesting CSD...\n");
-            check_errors(this->send_command(SD::CMD_RD_CSD, 0, SD::CRC_OTHER));
-            check_errors(this->read_block(16, response));
+            check_errors(
+                    this->send_command(SD::CMD_RD_CSD, 0, SD::RESPONSE_LEN_R1,
+                            NULL, SPI::SD_READ, response, 16));
             printf("CSD Contents:\n");
             this->print_hex_block(response, 16);
             putchar('\n');
 
             printf("Requesting CID...\n");
-            check_errors(this->send_command(SD::CMD_RD_CID, 0, SD::CRC_OTHER));
-            check_errors(this->read_block(16, response));
+            check_errors(
+                    this->send_command(SD::CMD_RD_CID, 0, SD::RESPONSE_LEN_R1,
+                            NULL, SPI::SD_READ, response, 16));
             printf("CID Contents:\n");
             this->print_hex_block(response, 16);
             putchar('\n');
@@ -1835,232 +2063,195 @@ class SD {
 #endif
 
         /**
-         * @brief       Send a command and argument over SPI to the SD card
-         *
-         * @param[in]   cmd     6-bit value representing the command sent to the
-         *                      SD card
-         * @param[in]   arg     Any argument applicable to the command
-         * @param[in]   crc     CRC for the command and argument
+         * @brief       Execute a command from start to finish in the SPI cog:
+         *              wait for the card to become ready, send the command and
+         *              argument, receive the response and then transfer the
+         *              data block, if any
+         *
+         * @param[in]   cmd             6-bit value representing the command
+         *                              sent to the SD card
+         * @param[in]   arg             Any argument applicable to the command
+         * @param[in]   responseLength  Number of bytes in the response,
+         *                              including the first (R1)
+         * @param[out]  response[]      Bytes of the response following the
+         *                              first; May be NULL for an R1 response
+         * @param[in]   phase           Data block transferred once the card
+         *                              accepts the command
+         * @param[in]   *block          Location in memory of the data block;
+         *                              Must stay in place until the command is
+         *                              complete
+         * @param[in]   length          Number of bytes in the data block
          *
          * @return      Returns 0 for success, else error code
          */
-        PropWare::ErrorCode send_command (const uint8_t cmd, const uint32_t arg,
-                const uint8_t crc) {
+        PropWare::ErrorCode send_command (const uint8_t cmd,
+                const uint32_t arg, const uint8_t responseLength,
+                uint8_t response[] = NULL,
+                const SPI::SDPhase phase = SPI::SD_NO_DATA,
+                uint8_t *block = NULL, const uint16_t length = 0) {
             PropWare::ErrorCode err;
+            SPI::SDCommand command;
+            uint32_t status;
+            uint8_t token;
+
+            command.frame = SPI::sd_frame(cmd, SD::crc7(cmd, arg), phase,
+                    responseLength);
+            command.argument = arg;
+            command.block = (uintptr_t) block;
+            command.length = length;
+            command.timeout = SD::RESPONSE_TIMEOUT;
+            check_errors(this->m_spi->sd_command(&command, &status));
+
+            this->m_firstByteResponse = (uint8_t) (status & SPI::SD_R1_BITS);
+            if (0xff == this->m_firstByteResponse)
+                return SD::READ_TIMEOUT;
+
+            // First byte in a response should always be either IDLE or ACTIVE
+            if ((SD::RESPONSE_IDLE != this->m_firstByteResponse)
+                    && (SD::RESPONSE_ACTIVE != this->m_firstByteResponse))
+                return SD::INVALID_RESPONSE;
 
-            // Send out the command
-            check_errors(this->m_spi->shift_out(8, cmd));
+            // Remaining bytes arrive most significant byte first
+            for (uint8_t i = 1; i < responseLength; ++i)
+                response[i - 1] = (uint8_t) (command.response >> (32 - 8 * i));
 
-            // Send argument
-            check_errors(this->m_spi->shift_out(16, (arg >> 16)));
-            check_errors(this->m_spi->shift_out(16, arg & WORD_0));
+            if (SPI::SD_NO_DATA == phase)
+                return 0;
 
-            // Send sixth byte - CRC
-            check_errors(this->m_spi->shift_out(8, crc));
+            // Data blocks only follow a command accepted by an active card
+            if (SD::RESPONSE_ACTIVE != this->m_firstByteResponse)
+                return SD::INVALID_RESPONSE;
+
+            token = (uint8_t) (status >> SPI::SD_TOKEN_OFFSET);
+            if (0xff == token)
+                return SD::READ_TIMEOUT;
+            if (SPI::SD_READ == phase) {
+                if (SD::DATA_START_ID != token)
+                    return SD::INVALID_DAT_STRT_ID;
+                if (status >> SPI::SD_CRC_ERROR_OFFSET)
+                    return SD::CRC_FAILURE;
+            } else if (SD::RSPNS_TKN_ACCPT
+                    != (token & (uint8_t) SD::RSPNS_TKN_BITS)) {
+                this->m_firstByteResponse = token;
+                return SD::INVALID_RESPONSE;
+            }
 
             return 0;
         }
 
         /**
-         * @brief       receive response and data from SD card over SPI
-         *
-         * @param[in]   numBytes    Number of bytes to receive
-         * @param[out]  *dat        Location in memory with enough space to 
-         *                          store `bytes` bytes of data
+         * @brief       Execute a command on the native bus from start to
+         *              finish, just like SD::send_command() does over SPI
+         *
+         * @param[in]   cmd             Command byte, including the start and
+         *                              transmission bits
+         * @param[in]   arg             Any argument applicable to the command
+         * @param[in]   responseType    One of SD::BUS_NO_RESPONSE, SD::BUS_R1,
+         *                              SD::BUS_R2, SD::BUS_R3, SD::BUS_R6 or
+         *                              SD::BUS_R7
+         * @param[out]  *response       The response's 32-bit argument (card
+         *                              status, OCR, etc); May be NULL
+         * @param[in]   phase           Data block transferred once the card
+         *                              accepts the command
+         * @param[in]   *block          Location in memory of the data block;
+         *                              Must be long-aligned
+         * @param[in]   length          Number of bytes in the data block
          *
          * @return      Returns 0 for success, else error code
          */
-        PropWare::ErrorCode get_response (uint8_t numBytes, uint8_t *dat) {
+        PropWare::ErrorCode send_bus_command (const uint8_t cmd,
+                const uint32_t arg, const uint8_t responseType,
+                uint32_t *response = NULL,
+                const SPI::SDPhase phase = SPI::SD_NO_DATA,
+                uint8_t *block = NULL, const uint16_t length = 0) {
             PropWare::ErrorCode err;
-            uint32_t timeout;
-
-            // Read first byte - the R1 response
-            timeout = SD::RESPONSE_TIMEOUT + CNT;
-            do {
-                check_errors(
-                        this->m_spi->shift_in(8, &this->m_firstByteResponse,
-                                sizeof(this->m_firstByteResponse)));
-
-                // Check for timeout
-                if (abs(timeout - CNT) < SD::SINGLE_BYTE_WIGGLE_ROOM)
+            SDBus::Command command;
+            uint32_t status, argument;
+            uint8_t responseLength = SDBus::SHORT_RESPONSE_BITS;
+
+            if (SD::BUS_NO_RESPONSE == responseType)
+                responseLength = 0;
+            else if (SD::BUS_R2 == responseType)
+                responseLength = SDBus::LONG_RESPONSE_BITS;
+
+            command.frame = SDBus::frame(cmd, SD::crc7(cmd, arg), phase,
+                    responseLength);
+            command.argument = arg;
+            command.block = (uintptr_t) block;
+            command.length = length;
+            command.timeout = SD::RESPONSE_TIMEOUT;
+            check_errors(this->m_bus->command(&command, &status));
+
+            switch (status & SDBus::FAILURE_BITS) {
+                case SDBus::BUSY_TIMEOUT:
+                case SDBus::RESPONSE_TIMEOUT:
                     return SD::READ_TIMEOUT;
+            }
 
-                // wait for transmission end
-            } while (0xff == this->m_firstByteResponse);
-
-            // First byte in a response should always be either IDLE or ACTIVE.
-            // If this one wans't, throw an error. If it was, decrement the
-            // bytes counter and read in all remaining bytes
-            if ((SD::RESPONSE_IDLE == this->m_firstByteResponse)
-                    || (SD::RESPONSE_ACTIVE == this->m_firstByteResponse)) {
-                --numBytes;    // Decrement bytes counter
-
-                // Read remaining bytes
-                while (numBytes--)
-                    check_errors(this->m_spi->shift_in(8, dat++, sizeof(*dat)));
-            } else
+            // A short response is split across two longs: the transmission
+            // bit, command index and the top 25 bits of the argument, then the
+            // rest of the argument, the CRC7 and the end bit
+            argument = (command.response[0] << 7) | (command.response[1] >> 8);
+            if (SD::BUS_R1 <= responseType && SD::BUS_R2 != responseType
+                    && SD::BUS_R3 != responseType) {
+                if ((cmd & SD::BUS_INDEX_BITS)
+                        != (command.response[0] >> 25))
+                    return SD::INVALID_RESPONSE;
+                if (SD::crc7(cmd & SD::BUS_INDEX_BITS, argument)
+                        != (uint8_t) command.response[1])
+                    return SD::CRC_FAILURE;
+            }
+            if (SD::BUS_R1 == responseType
+                    && (SD::CARD_STATUS_ERRORS & argument)) {
+                this->m_firstByteResponse = (uint8_t) (argument >> 24);
                 return SD::INVALID_RESPONSE;
+            }
+            if (NULL != response)
+                *response = argument;
 
-            // Responses should always be followed up by outputting 8 clocks
-            // with MOSI high
-            check_errors(this->m_spi->shift_out(16, (uint32_t) -1));
-            check_errors(this->m_spi->shift_out(16, (uint32_t) -1));
-            check_errors(this->m_spi->shift_out(16, (uint32_t) -1));
-            check_errors(this->m_spi->shift_out(16, (uint32_t) -1));
-
-            return 0;
-        }
-
-        /**
-         * @brief       Receive data from SD card via SPI
-         *
-         * @param[in]   bytes   Number of bytes to receive
-         * @param[out]  *dat    Location in memory with enough space to store
-         *                      `bytes` bytes of data
-         *
-         * @return      Returns 0 for success, else error code
-         */
-        PropWare::ErrorCode read_block (uint16_t bytes, uint8_t *dat) {
-            uint8_t i, err, checksum;
-            uint32_t timeout;
-
-            // Read first byte - the R1 response
-            timeout = SD::RESPONSE_TIMEOUT + CNT;
-            do {
-                check_errors(
-                        this->m_spi->shift_in(8, &this->m_firstByteResponse,
-                                sizeof(this->m_firstByteResponse)));
-
-                // Check for timeout
-                if (abs(timeout - CNT) < SD::SINGLE_BYTE_WIGGLE_ROOM)
+            switch (status & SDBus::FAILURE_BITS) {
+                case SDBus::DATA_TIMEOUT:
                     return SD::READ_TIMEOUT;
+                case SDBus::DATA_CRC:
+                    return SD::CRC_FAILURE;
+            }
 
-                // wait for transmission end
-            } while (0xff == this->m_firstByteResponse);
-
-            // Ensure this response is "active"
-            if (SD::RESPONSE_ACTIVE == this->m_firstByteResponse) {
-                // Ignore blank data again
-                timeout = SD::RESPONSE_TIMEOUT + CNT;
-                do {
-                    check_errors(this->m_spi->shift_in(8, dat, sizeof(*dat)));
-
-                    // Check for timeout
-                    if (abs(timeout - CNT) < SD::SINGLE_BYTE_WIGGLE_ROOM)
-                        return SD::READ_TIMEOUT;
-
-                    // wait for transmission end
-                } while (SD::DATA_START_ID != *dat);
-
-                // Check for the data start identifier and continue reading data
-                if (SD::DATA_START_ID == *dat) {
-                    // Read in requested data bytes
-#if (defined SPI_FAST_SECTOR)
-                    if (SD::SECTOR_SIZE == bytes) {
-                        this->m_spi->shift_in_sector(dat, 1);
-                        bytes = 0;
-                    }
-#endif
-                    while (bytes--) {
-#ifdef SPI_OPTION_FAST
-                        check_errors(
-                                this->m_spi->shift_in_fast(8, dat++,
-                                        sizeof(*dat)));
-#else
-                        check_errors(this->m_spi->shift_in(8, dat++,
-                                        sizeof(*dat)));
-#endif
-                    }
-
-                    // Read two more bytes for checksum - throw away data
-                    for (i = 0; i < 2; ++i) {
-                        timeout = SD::RESPONSE_TIMEOUT + CNT;
-                        do {
-                            check_errors(
-                                    this->m_spi->shift_in(8, &checksum,
-                                            sizeof(checksum)));
-
-                            // Check for timeout
-                            if ((timeout - CNT) < SD::SINGLE_BYTE_WIGGLE_ROOM)
-                                return SD::READ_TIMEOUT;
-
-                            // wait for transmission end
-                        } while (0xff == checksum);
-                    }
-
-                    // Send final 0xff
-                    check_errors(this->m_spi->shift_out(8, 0xff));
-                } else {
-                    return SD::INVALID_DAT_STRT_ID;
-                }
-            } else
+            if (SPI::SD_WRITE == phase && SDBus::CRC_STATUS_ACCEPTED
+                    != (status >> SDBus::CRC_STATUS_OFFSET)) {
+                this->m_firstByteResponse = (uint8_t) (status
+                        >> SDBus::CRC_STATUS_OFFSET);
                 return SD::INVALID_RESPONSE;
+            }
 
             return 0;
         }
 
         /**
-         * @brief       Write data to SD card via SPI
+         * @brief       Compute the CRC7 of a command and its argument
          *
-         * @param[in]   bytes   Block address to read from SD card
-         * @param[in]   *dat    Location in memory where data resides
+         * @param[in]   cmd     Command byte, including the start and
+         *                      transmission bits
+         * @param[in]   arg     Argument sent with the command
          *
-         * @return      Returns 0 upon success, error code otherwise
+         * @return      The CRC7 in the upper seven bits with the end bit set,
+         *              ready to be sent as the final byte of the command
          */
-        PropWare::ErrorCode write_block (uint16_t bytes, uint8_t *dat) {
-            PropWare::ErrorCode err;
-            uint32_t timeout;
-
-            // Read first byte - the R1 response
-            timeout = SD::RESPONSE_TIMEOUT + CNT;
-            do {
-                check_errors(
-                        this->m_spi->shift_in(8, &this->m_firstByteResponse,
-                                sizeof(this->m_firstByteResponse)));
-
-                // Check for timeout
-                if (abs(timeout - CNT) < SD::SINGLE_BYTE_WIGGLE_ROOM)
-                    return SD::READ_TIMEOUT;
-
-                // wait for transmission end
-            } while (0xff == this->m_firstByteResponse);
-
-            // Ensure this response is "active"
-            if (SD::RESPONSE_ACTIVE == this->m_firstByteResponse) {
-                // Received "active" response
-
-                // Send data Start ID
-                check_errors(this->m_spi->shift_out(8, SD::DATA_START_ID));
-
-                // Send all bytes
-                while (bytes--) {
-#ifdef SPI_OPTION_FAST
-                    check_errors(this->m_spi->shift_out_fast(8, *(dat++)));
-#else
-                    check_errors(this->m_spi->shift_out(8, *(dat++)));
-#endif
+        static uint8_t crc7 (const uint8_t cmd, const uint32_t arg) {
+            uint8_t crc = 0;
+            uint8_t i, j, byte;
+
+            for (i = 0; i < SD::ARG_LEN; ++i) {
+                byte = i ? (uint8_t) (arg >> (8 * (SD::ARG_LEN - 1 - i))) : cmd;
+                for (j = 0; j < 8; ++j) {
+                    if ((byte ^ crc) & BIT_7)
+                        crc = (uint8_t) ((crc << 1) ^ SD::CRC7_POLY);
+                    else
+                        crc <<= 1;
+                    byte <<= 1;
                 }
-
-                // Receive and digest response token
-                timeout = SD::RESPONSE_TIMEOUT + CNT;
-                do {
-                    check_errors(
-                            this->m_spi->shift_in(8, &this->m_firstByteResponse,
-                                    sizeof(this->m_firstByteResponse)));
-
-                    // Check for timeout
-                    if (abs(timeout - CNT) < SD::SINGLE_BYTE_WIGGLE_ROOM)
-                        return SD::READ_TIMEOUT;
-
-                    // wait for transmission end
-                } while (0xff == this->m_firstByteResponse);
-                if (SD::RSPNS_TKN_ACCPT
-                        != (this->m_firstByteResponse
-                                & (uint8_t) SD::RSPNS_TKN_BITS))
-                    return SD::INVALID_RESPONSE;
             }
 
-            return 0;
+            return (uint8_t) (crc | 1);
         }
 
         /**
@@ -2077,24 +2268,25 @@ class SD {
              * thrown, chip select is set high again before returning the error
              */
             PropWare::ErrorCode err;
-            uint8_t temp = 0;
-
-            // Wait until the SD card is no longer busy
-            while (!temp)
-                this->m_spi->shift_in(8, &temp, sizeof(temp));
 
 #ifdef SD_OPTION_VERBOSE
             printf("Reading block at sector address: 0x%08x / %u\n", address,
                     address);
 #endif
 
-            this->m_cs.clear();
+            if (NULL != this->m_bus)
+                return this->send_bus_command(SD::CMD_RD_BLOCK, address,
+                        SD::BUS_R1, NULL, SPI::SD_READ, dat, SD::SECTOR_SIZE);
 
-            err = this->send_command(SD::CMD_RD_BLOCK, address, SD::CRC_OTHER);
-            if (!err)
-                err = this->read_block(SD::SECTOR_SIZE, dat);
+            check_errors(this->m_spi->select(this->m_profile));
 
-            this->m_cs.set();
+            // The SPI cog waits for the card, reads the block and checks its
+            // CRC in a single command
+            err = this->send_command(SD::CMD_RD_BLOCK, address,
+                    SD::RESPONSE_LEN_R1, NULL, SPI::SD_READ, dat,
+                    SD::SECTOR_SIZE);
+
+            this->m_spi->deselect(this->m_profile);
 
             if (err)
                 return err;
@@ -2112,23 +2304,26 @@ class SD {
          */
         PropWare::ErrorCode write_data_block (uint32_t address, uint8_t *dat) {
             PropWare::ErrorCode err;
-            uint8_t temp = 0;
-
-            // Wait until the SD card is no longer busy
-            while (!temp)
-                this->m_spi->shift_in(8, &temp, 1);
 
 #ifdef SD_OPTION_VERBOSE
             printf("Writing block at address: 0x%08x / %u\n", address, address);
 #endif
 
-            this->m_cs.clear();
-            check_errors(
-                    this->send_command(SD::CMD_WR_BLOCK, address,
-                            SD::CRC_OTHER));
+            if (NULL != this->m_bus)
+                return this->send_bus_command(SD::CMD_WR_BLOCK, address,
+                        SD::BUS_R1, NULL, SPI::SD_WRITE, dat, SD::SECTOR_SIZE);
 
-            check_errors(this->write_block(SD::SECTOR_SIZE, dat));
-            this->m_cs.set();
+            check_errors(this->m_spi->select(this->m_profile));
+
+            // Chip select and the bus are released even upon an error
+            err = this->send_command(SD::CMD_WR_BLOCK, address,
+                    SD::RESPONSE_LEN_R1, NULL, SPI::SD_WRITE, dat,
+                    SD::SECTOR_SIZE);
+
+            this->m_spi->deselect(this->m_profile);
+
+            if (err)
+                return err;
 
             return 0;
         }
@@ -3163,9 +3358,8 @@ class SD {
         static const SPI::BitMode SPI_BITMODE = SPI::MSB_FIRST;
 
         // Misc. SD Definitions
-        static const uint32_t RESPONSE_TIMEOUT;  // Wait 0.1 seconds for a response before timing out
+        static const uint32_t RESPONSE_TIMEOUT;  // Wait 0.25 seconds for the card at each step of a command before timing out
         static const uint32_t SEND_ACTIVE_TIMEOUT;
-        static const uint32_t SINGLE_BYTE_WIGGLE_ROOM;
         static const uint8_t SECTOR_SIZE_SHIFT = 9;
 
         // SD Commands
@@ -3178,6 +3372,11 @@ class SD {
         static const uint8_t CMD_WR_OP = 0x40 + 41;  // Send operating conditions for SDC
         static const uint8_t CMD_APP = 0x40 + 55;  // Inform card that following instruction is application specific
         static const uint8_t CMD_READ_OCR = 0x40 + 58;  // Request "Operating Conditions Register" contents
+        static const uint8_t CMD_CRC_ON_OFF = 0x40 + 59;  // Enable or disable CRC checking by the card
+        static const uint8_t CMD_ALL_SEND_CID = 0x40 + 2;  // Native bus: request the CID of every card in identification mode
+        static const uint8_t CMD_SEND_RCA = 0x40 + 3;  // Native bus: request a new relative card address
+        static const uint8_t CMD_SET_BUS_WIDTH = 0x40 + 6;  // Native bus: select 1 or 4 data lines (application specific)
+        static const uint8_t CMD_SELECT = 0x40 + 7;  // Native bus: select the card with the given relative address
 
         // SD Arguments
         static const uint32_t HOST_VOLTAGE_3V3 = 0x01;
@@ -3185,13 +3384,13 @@ class SD {
         static const uint32_t ARG_CMD8 = ((SD::HOST_VOLTAGE_3V3 << 8)
                 | SD::R7_CHECK_PATTERN);
         static const uint32_t ARG_LEN = 5;
+        static const uint32_t ARG_CRC_ON = 1;
+        static const uint32_t ARG_CMD8_BITS = 0xfff;  // Voltage accepted and check pattern, as echoed in R7
+        static const uint32_t ARG_BUS_WR_OP = BIT_30 | BIT_21 | BIT_20;  // High capacity support, 3.2V - 3.4V
+        static const uint32_t ARG_BUS_WIDTH_4 = 2;
 
         // SD CRCs
-        static const uint8_t CRC_IDLE = 0x95;
-        static const uint8_t CRC_CMD8 = 0x87;  // CRC only valid for CMD8 argument of 0x000001AA
-        static const uint8_t CRC_ACMD_PREP = 0x65;
-        static const uint8_t CRC_ACMD = 0x77;
-        static const uint8_t CRC_OTHER = 0x01;
+        static const uint8_t CRC7_POLY = 0x09 << 1;  // x^7 + x^3 + 1, aligned with bits 7..1 of the CRC byte
 
         // SD Responses
         static const uint8_t RESPONSE_IDLE = 0x01;
@@ -3205,6 +3404,18 @@ class SD {
         static const uint8_t RSPNS_TKN_CRC = (0x05 << 1) | 1;
         static const uint8_t RSPNS_TKN_WR = (0x06 << 1) | 1;
 
+        // Native bus responses
+        static const uint8_t BUS_NO_RESPONSE = 0;
+        static const uint8_t BUS_R1 = 1;  // Card status
+        static const uint8_t BUS_R2 = 2;  // CID or CSD, 136 bits
+        static const uint8_t BUS_R3 = 3;  // OCR; Neither the index nor the CRC7 are valid
+        static const uint8_t BUS_R6 = 6;  // Relative card address
+        static const uint8_t BUS_R7 = 7;  // Interface condition
+        static const uint8_t BUS_INDEX_BITS = 0x3f;
+        static const uint32_t OCR_POWERED_UP = BIT_31;
+        static const uint32_t RCA_BITS = 0xffff0000;
+        static const uint32_t CARD_STATUS_ERRORS = 0xfdf98008;  // Every error bit of the card status
+
         // Boot sector addresses/values
         static const uint8_t FAT_16 = 2;  // A FAT entry in FAT16 is 2-bytes
         static const uint8_t FAT_32 = -4;  // A FAT entry in FAT32 is 4-bytes
@@ -3269,7 +3480,10 @@ class SD {
          *** Private Member Variable ***
          *******************************/
         SPI *m_spi;
-        PropWare::Pin m_cs;  // Chip select pin mask
+        SDBus *m_bus;  // Native bus used in place of m_spi when not NULL
+        uint32_t m_rca;  // Relative card address on the native bus, in bits 31-16 as it is sent
+        PropWare::Pin m_cs;  // Chip select pin mask; Only driven by this cog during initialization
+        SPI::ProfileId m_profile;  // Settings and chip select handed to the SPI cog after initialization
         uint8_t m_filesystem;  // File system type - one of SD::FAT_16 or SD::FAT_32
         uint8_t m_sectorsPerCluster_shift;  // Used as a quick multiply/divide; Stores log_2(Sectors per Cluster)
         uint32_t m_rootDirSectors;  // Number of sectors for the root directory
@@ -0,0 +1,330 @@
+/**
+ * @file        sdbus.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_SDBUS_H_
+#define PROPWARE_SDBUS_H_
+
+#include <propeller.h>
+#include <PropWare/PropWare.h>
+#include <PropWare/port.h>
+#include <PropWare/spi.h>
+
+namespace PropWare {
+
+// Symbol for assembly instructions to start a new native SD bus cog
+extern "C" {
+extern uint32_t _SDBusStartCog (void *arg);
+}
+
+/**
+ * @brief       Native (4-bit) SD bus for PropWare::SD; A dedicated assembly
+ *              cog drives CLK and CMD and moves data blocks on DAT0-DAT3
+ *
+ * In place of a single MISO line, the data blocks are transferred four bits
+ * per clock with a CRC16 for each data line, all computed and checked in the
+ * cog. Only one command is in progress at a time: SDBus::command() returns
+ * once the cog has finished with it.
+ *
+ * DAT0-DAT3 must be four consecutive pins, DAT0 the lowest. CMD and all four
+ * data lines require pull-up resistors (10k-100k) as described by the SD
+ * specification; DAT3 in particular must not be low when the card is reset,
+ * or the card enters SPI mode.
+ *
+ * Timing, with CLKFREQ the system clock:
+ * <ul><li>Commands, responses and the waits between them are clocked at the
+ * frequency given to SDBus::set_clock(), or as fast as the cog can for
+ * frequencies above CLKFREQ/64</li>
+ * <li>Data blocks are always clocked as fast as the cog can: about CLKFREQ/24
+ * (3.3 MHz at 80 MHz) within each group of eight nibbles, or roughly 1 MB/s
+ * including the CRC and hub accesses</li></ul>
+ */
+class SDBus {
+    public:
+        /**
+         * @brief   Shared with the SD bus cog; Everything above delay is only
+         *          read when the cog starts
+         */
+        typedef struct {
+            uint32_t clk;
+            uint32_t cmd;
+            /** Pin number of DAT0 */
+            uint32_t dat0;
+            /** Cycles in each half of a CLK period; Zero for full speed */
+            volatile uint32_t delay;
+            /** Hub address of the command in progress; Cleared by the cog once
+             *  it is complete */
+            volatile uintptr_t command;
+            /** Written by the cog before the command is cleared */
+            volatile uint32_t result;
+        } Control;
+
+        /**
+         * @brief   A single command, its response and its data block, if any;
+         *          Must be long-aligned
+         */
+        typedef struct {
+            /** See SDBus::frame() */
+            uint32_t frame;
+            uint32_t argument;
+            /** Hub address of the data block; Must be long-aligned */
+            uintptr_t block;
+            /** Number of bytes in the data block; A multiple of four */
+            uint32_t length;
+            /** Cycles allowed for each wait on the card: for it to finish
+             *  programming, to respond and to send or accept a data block */
+            uint32_t timeout;
+            /** Response bits following the start bit, 32 to a long with the
+             *  first received in bit 31 of the first long; The last long
+             *  holds the remaining bits, right-aligned. Written by the cog */
+            volatile uint32_t response[5];
+        } Command;
+
+        /**
+         * @brief   Failures reported in bits 7-0 of the status from
+         *          SDBus::command()
+         */
+        typedef enum {
+            /** The command completed */NO_FAILURE,
+            /** The card never released DAT0 */BUSY_TIMEOUT,
+            /** No response started on CMD */RESPONSE_TIMEOUT,
+            /** No data block or CRC status started on DAT0 */DATA_TIMEOUT,
+            /** The data block read did not match its CRC16 */DATA_CRC
+        } Failure;
+
+        /** Bits of the status from SDBus::command() holding the failure */
+        static const uint32_t FAILURE_BITS = BYTE_0;
+        /** The card's CRC status for a written block is found in bits 10-8 */
+        static const uint8_t CRC_STATUS_OFFSET = 8;
+        /** CRC status of a block accepted by the card */
+        static const uint8_t CRC_STATUS_ACCEPTED = 0x2;
+
+        /** Number of bits in R1, R3, R6 and R7 responses */
+        static const uint8_t SHORT_RESPONSE_BITS = 48;
+        /** Number of bits in R2 responses */
+        static const uint8_t LONG_RESPONSE_BITS = 136;
+
+    public:
+        SDBus () {
+            memset(&this->m_control, 0, sizeof(this->m_control));
+            this->m_cog = -1;
+        }
+
+        ~SDBus () {
+            this->stop();
+        }
+
+        /**
+         * @brief       Start the SD bus cog, which sends the card the clocks it
+         *              requires after power-up
+         *
+         * @param[in]   clk         Pin mask for CLK
+         * @param[in]   cmd         Pin mask for CMD
+         * @param[in]   dat0        Pin mask for DAT0; DAT1-DAT3 are the three
+         *                          pins above it
+         * @param[in]   frequency   Frequency, in Hz, of CLK outside of data
+         *                          blocks; No more than 400 kHz until the card
+         *                          has been assigned a relative address
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode start (const PropWare::Port::Mask clk,
+                const PropWare::Port::Mask cmd,
+                const PropWare::Port::Mask dat0, const int32_t frequency) {
+            PropWare::ErrorCode err;
+
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (PropWare::Port::P28 < dat0)
+                return SPI::INVALID_PIN;
+#endif
+
+            if (this->is_running())
+                this->stop();
+
+            this->m_control.clk = clk;
+            this->m_control.cmd = cmd;
+            this->m_control.dat0 = PropWare::Port::convert(dat0);
+            this->m_control.command = 0;
+            check_errors(this->set_clock(frequency));
+
+            this->m_cog = (int8_t) PropWare::_SDBusStartCog(
+                    (void *) &this->m_control);
+            if (!this->is_running())
+                return SPI::COG_NOT_STARTED;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Stop the SD bus cog, releasing every pin
+         */
+        void stop () {
+            if (this->is_running()) {
+                cogstop(this->m_cog);
+                this->m_cog = -1;
+            }
+        }
+
+        /**
+         * @brief   Determine if the SD bus cog is running
+         */
+        bool is_running () const {
+            return -1 != this->m_cog;
+        }
+
+        /**
+         * @brief       Change the frequency of CLK outside of data blocks;
+         *              Takes effect with the next command
+         *
+         * @param[in]   frequency   Frequency, in Hz
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode set_clock (const int32_t frequency) {
+            uint32_t delay;
+
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (0 >= frequency)
+                return SPI::INVALID_FREQ;
+#endif
+
+            delay = (CLKFREQ / frequency) >> 1;
+            if (SDBus::MIN_DELAY > delay)
+                delay = 0;
+            this->m_control.delay = delay;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Pack the fixed part of a command for
+         *              SDBus::Command::frame
+         *
+         * @param[in]   cmd             Command byte, including the start and
+         *                              transmission bits
+         * @param[in]   crc             CRC7 byte, including the end bit
+         * @param[in]   phase           Data block transferred after the
+         *                              response
+         * @param[in]   responseLength  Number of bits in the response,
+         *                              including the start bit; Zero if the
+         *                              command has no response
+         */
+        static uint32_t frame (const uint8_t cmd, const uint8_t crc,
+                const SPI::SDPhase phase, const uint8_t responseLength) {
+            const uint32_t responseBits = responseLength ?
+                    responseLength - 1U : 0;
+
+            return cmd | (crc << SDBus::CRC_OFFSET)
+                    | ((uint32_t) phase << SDBus::PHASE_OFFSET)
+                    | (responseBits << SDBus::RESPONSE_BITS_OFFSET);
+        }
+
+        /**
+         * @brief       Execute a command from start to finish: wait for the
+         *              card to become ready, send the command, receive the
+         *              response and then transfer the data block, if any
+         *
+         * @param[in]   *command    Command to execute; Must stay in place, and
+         *                          its data block must not be touched, until
+         *                          this call returns
+         * @param[out]  *status     Failure, if any, and CRC status; See
+         *                          SDBus::FAILURE_BITS and friends
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode command (SDBus::Command *command,
+                uint32_t *status) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (((uintptr_t) command & 3) || (command->block & 3))
+                return SPI::ADDR_MISALIGN;
+            if (command->length & 3)
+                return SPI::INVALID_BYTE_SIZE;
+#endif
+
+            this->m_control.command = (uintptr_t) command;
+
+            // Each of the cog's waits may run for the full timeout, on top of
+            // the bits that are always clocked
+            const uint32_t timeoutCnt = SDBus::TIMEOUT_VAL + CNT
+                    + SDBus::WAITS * command->timeout
+                    + SDBus::FRAME_CLOCKS * ((this->m_control.delay << 1)
+                            + SDBus::CLOCK_CYCLES)
+                    + (command->length << 1) * SDBus::NIBBLE_CYCLES;
+            while (this->m_control.command)
+                if (abs(timeoutCnt - CNT) < SDBus::TIMEOUT_WIGGLE_ROOM) {
+                    // The cog must not write to the command once the caller
+                    // has moved on, so it is started afresh
+                    this->restart();
+                    return SPI::TIMEOUT;
+                }
+
+            *status = this->m_control.result;
+            return SPI::NO_ERROR;
+        }
+
+    protected:
+        void restart () {
+            cogstop(this->m_cog);
+            this->m_control.command = 0;
+            this->m_cog = (int8_t) PropWare::_SDBusStartCog(
+                    (void *) &this->m_control);
+        }
+
+    protected:
+        static const uint8_t CRC_OFFSET = 8;
+        static const uint8_t PHASE_OFFSET = 16;
+        static const uint8_t RESPONSE_BITS_OFFSET = 24;
+
+        /** Smallest half period the cog can time with WAITCNT */
+        static const uint32_t MIN_DELAY = 32;
+        /** Waits on the card within a command: busy, response, data block
+         *  and CRC status */
+        static const uint8_t WAITS = 4;
+        /** Upper bound on the clocks of everything but the data block */
+        static const uint16_t FRAME_CLOCKS = 512;
+        /** Upper bound on the cycles taken by a slow clock on top of its two
+         *  halves */
+        static const uint8_t CLOCK_CYCLES = 64;
+        /** Upper bound on the cycles taken by each nibble of a data block,
+         *  including its share of the CRC and hub accesses */
+        static const uint8_t NIBBLE_CYCLES = 64;
+        static const uint32_t TIMEOUT_VAL = 8 * 1024;
+        static const uint16_t TIMEOUT_WIGGLE_ROOM = 400;
+
+    protected:
+        SDBus::Control m_control;
+        int8_t m_cog;
+
+    private:
+        // The cog holds the address of the control block: an instance can be
+        // neither copied nor assigned
+        SDBus (const SDBus &);
+        SDBus& operator= (const SDBus &);
+};
+
+}
+
+#endif /* PROPWARE_SDBUS_H_ */
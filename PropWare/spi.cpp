@@ -29,3 +29,6 @@
 // Constants that use CLKFREQ cannot be initialized in the header
 const uint32_t PropWare::SPI::WR_TIMEOUT_VAL = CLKFREQ / 10;
 const int32_t PropWare::SPI::MAX_CLOCK = CLKFREQ >> 3;
+
+// Constructed before main() so that no two cogs can race to construct it
+PropWare::SPI PropWare::SPI::s_instance;
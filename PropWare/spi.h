@@ -32,6 +32,7 @@
 #include <sys/thread.h>
 #include <PropWare/PropWare.h>
 #include <PropWare/pin.h>
+#include <PropWare/spibus.h>
 
 #if (defined USE_PRINTF)
 #if (!(defined __TINY_IO_H || _STDIO_H))
@@ -61,13 +62,32 @@ extern int printf(const char *fmt, ...);
  */
 #define SPI_OPTION_FAST
 /**
- * TODO: Figure out why this doesn't work... :(
+ * Keep statistics of SPI cog activity, retrieved with
+ * PropWare::SPI::get_stats(); Costs nothing when disabled
+ *
+ * @note    The SPI cog is assembled separately, so PropWare (spi_as.S) must be
+ *          built with SPI_OPTION_STATS defined as well for the cycle counts to
+ *          be recorded
+ * <p>
+ * DEFAULT: Off
+ */
+#define SPI_OPTION_STATS
+// This allows Doxygen to document the macro without permanently enabling it
+#undef SPI_OPTION_STATS
+/**
+ * Transmit blocks with the SPI cog's video generator at CLKFREQ/4, enabled
+ * with PropWare::SPI::set_video_transmit()
+ *
+ * @note    The SPI cog is assembled separately, so PropWare (spi_as.S) must be
+ *          built with SPI_OPTION_VIDEO defined as well. The video generator's
+ *          transmit path takes the place of the counter clock's in the cog,
+ *          which leaves room for SPI_OPTION_STATS but nothing more
  * <p>
  * DEFAULT: Off
  */
-#define SPI_OPTION_FAST_SECTOR
+#define SPI_OPTION_VIDEO
 // This allows Doxygen to document the macro without permanently enabling it
-#undef SPI_OPTION_FAST_SECTOR
+#undef SPI_OPTION_VIDEO
 /** @} */
 
 namespace PropWare {
@@ -81,59 +101,89 @@ extern uint32_t _SPIStartCog (void *arg);
  * @brief       SPI serial communications library; Core functionality comes from
  *              a dedicated assembly cog
  *
- * Generally, multiple instances of the SPI class are not desired. To avoid
- * the programmer from accidentally creating multiple instances, this class is
- * set up as a singleton. A static instance can be retrieved with
- * PropWare::SPI::getInstance(). If multiple instances of PropWare::SPI are
- * desired, the PropWare library (and your project) should be built from
- * source with PROPWARE_NO_SAFE_SPI defined
+ * Every instance is an independent bus with its own cog, mailbox, descriptor
+ * ring, hardware lock and pins, so a slow device (such as an SD card) on one
+ * bus never holds up a device on another. The default bus, shared by every
+ * driver that is not told otherwise, is retrieved with
+ * PropWare::SPI::getInstance(); Additional buses are simply constructed:
+ *
+ *     PropWare::SPI adcBus;
+ *     adcBus.start(PropWare::Port::P4, PropWare::Port::P5, PropWare::Port::P6,
+ *             4000000, PropWare::SPI::MODE_0, PropWare::SPI::MSB_FIRST);
+ *     PropWare::MCP3000 adc(&adcBus, PropWare::MCP3000::MCP300x);
+ *
+ * No two buses may share MOSI or SCLK. An instance must not move while its cog
+ * is running, as the cog keeps the address of its mailbox
+ *
+ * An instance may be shared by any number of cogs. Every method that talks to
+ * the SPI cog claims the bus (a hardware lock) for its own duration, so calls
+ * from different cogs never interleave. Anything between asserting and
+ * releasing chip select must keep the bus across several calls, so a cog opens
+ * a transaction with SPI::select() or SPI::lock(). While a cog owns the bus,
+ * its calls skip the hardware lock entirely and other cogs wait in their next
+ * call until the transaction is closed with SPI::deselect() or SPI::unlock()
  */
-class SPI {
+class SPI: public PropWare::SPIBus {
 #define check_errors_w_str(x, y) \
-        if ((err = x)) {strcpy(this->m_errorInMethod, y);return err;}
+        if ((err = x)) {this->set_error_method(y);return err;}
 
     public:
         /**
-         * @brief   Descriptor for SPI signal as defined by Motorola modes
+         * @brief   Transfer descriptor shared with the SPI cog through the hub
+         *          ring; See SPI::submit_shift_out() and friends
          *
-         * CPOL 0 refers to a low polarity (where the clock idles in the low
-         * state) and CPOL 1 is for high polarity.
-         * TODO: Describe phase
-         * <table><tr><td>SPI Mode</td><td>CPOL</td><td>CPHA</td></tr><tr>
-         * <td>0</td><td>0</td><td>0</td></tr><tr><td>1</td><td>0</td><td>1</td>
-         * </tr><tr><td>2</td><td>1</td><td>0</td></tr><tr><td>3</td><td>1</td>
-         * <td>1</td></tr></table>
+         * Fields that may hold a hub address are pointer-sized: a long on the
+         * Propeller, and wide enough for a host pointer in the host build
          */
-        /* Raw text version of the above HTML table
-         *
-         * SPI Mode     CPOL    CPHA
-         * 0            0       0
-         * 1            0       1
-         * 2            1       0
-         * 3            1       1
+        typedef struct {
+            /** Function and bit count; SPI::QUEUE_PENDING is set while the
+             *  descriptor is owned by the SPI cog */
+            volatile uint32_t op;
+            /** Value to be sent (replaced by the value received), or hub
+             *  address of a block */
+            volatile uintptr_t data;
+            /** Number of bytes in a block, or hub address of the channels of
+             *  a gang transfer */
+            volatile uintptr_t length;
+        } Descriptor;
+
+        /**
+         * Identifies a submitted transfer; Valid for SPI::poll() and
+         * SPI::wait_for()
          */
-        typedef enum {
-            /** Mode 0 */MODE_0,
-            /** Mode 1 */MODE_1,
-            /** Mode 2 */MODE_2,
-            /** Mode 3 */MODE_3,
-        } Mode;
+        typedef uint32_t Ticket;
 
         /**
-         * @brief   Determine if data is communicated with the LSB or MSB
-         *          sent/received first
-         *
-         * @note    Initial value is SPI_MODES + 1 making them easily
-         *          distinguishable
+         * Data block, if any, transferred by SPI::sd_command() once the card
+         * accepts the command
          */
         typedef enum {
-            /**
-             * Start the enumeration where SPI::Mode left off; this ensures no
-             * overlap
-             */
-            LSB_FIRST = SPI::MODE_3 + 1,
-            MSB_FIRST
-        } BitMode;
+            /** No data block */SD_NO_DATA,
+            /** Receive a data block */SD_READ,
+            /** Send a data block */SD_WRITE
+        } SDPhase;
+
+        /**
+         * @brief   An SD card command, executed in full by the SPI cog; See
+         *          SPI::sd_command()
+         */
+        typedef struct {
+            /** Command byte, CRC7, data phase and response length, as packed
+             *  by SPI::sd_frame() */
+            uint32_t frame;
+            /** Argument sent with the command */
+            uint32_t argument;
+            /** Hub address of the data block, if any */
+            uintptr_t block;
+            /** Number of bytes in the data block */
+            uint32_t length;
+            /** Clock cycles to wait for the card at each step: while it is
+             *  busy, for R1 and for the start or data-response token */
+            uint32_t timeout;
+            /** Response bytes following R1, the first received in bits 31-24;
+             *  Written by the SPI cog */
+            volatile uint32_t response;
+        } SDCommand;
 
         /**
          * Error codes - Proceeded by nothing
@@ -155,7 +205,12 @@ class SPI {
             /** SPI Error 11 */INVALID_BYTE_SIZE,
             /** SPI Error 12 */ADDR_MISALIGN,
             /** SPI Error 13 */INVALID_BITMODE,
-            /** Last SPI error code */END_ERROR = SPI::INVALID_BITMODE
+            /** SPI Error 14 */INVALID_PROFILE,
+            /** SPI Error 15 */TOO_MANY_PROFILES,
+            /** SPI Error 16 */NOT_BUS_OWNER,
+            /** SPI Error 17 */INVALID_BUFFER_SIZE,
+            /** SPI Error 18 */TOO_MANY_CHANNELS,
+            /** Last SPI error code */END_ERROR = SPI::TOO_MANY_CHANNELS
         } ErrorCode;
 
     public:
@@ -163,14 +218,80 @@ class SPI {
         // error
         static const uint32_t WR_TIMEOUT_VAL;
         static const uint32_t RD_TIMEOUT_VAL;
-        static const uint8_t MAX_PAR_BITS = 31;
+        static const uint8_t MAX_PAR_BITS = 32;
+        /** Number of transfers that can be queued before submission blocks;
+         *  Must match SPI_QUEUE_LENGTH in spi_as.S */
+        static const uint8_t QUEUE_LENGTH = 8;
+        /** Number of device profiles that can be registered at once; Must
+         *  match SPI_MAX_PROFILES in spi_as.S */
+        static const uint8_t MAX_PROFILES = 8;
+        /** Number of devices that one gang transfer can read; Each is held in
+         *  registers of GANG_TRANSFER in spi_as.S */
+        static const uint8_t MAX_GANG_CHANNELS = 4;
         static const int32_t MAX_CLOCK;
 
-#ifndef PROPWARE_NO_SAFE_SPI
-    private:
-#else
-    public:
+        /** @name   Function codes of the SPI cog
+         * @{ */
+        static const uint8_t FUNC_SEND = 0;
+        static const uint8_t FUNC_READ = 1;
+        static const uint8_t FUNC_SEND_FAST = 2;
+        static const uint8_t FUNC_READ_FAST = 3;
+        static const uint8_t FUNC_SD_COMMAND = 4;
+        static const uint8_t FUNC_SET_MODE = 5;
+        static const uint8_t FUNC_SET_BITMODE = 6;
+        static const uint8_t FUNC_SET_FREQ = 7;
+        static const uint8_t FUNC_GET_FREQ = 8;
+        static const uint8_t FUNC_SEND_BLOCK = 9;
+        static const uint8_t FUNC_READ_BLOCK = 10;
+        static const uint8_t FUNC_SET_CTR_CLK = 11;
+        // 12 is unused
+        static const uint8_t FUNC_TRANSFER = 13;
+        static const uint8_t FUNC_TRANSFER_BLOCK = 14;
+        static const uint8_t FUNC_SELECT = 15;
+        static const uint8_t FUNC_DESELECT = 16;
+        // 17 is unused
+        static const uint8_t FUNC_GANG_TRANSFER = 18;
+        /** Number of function codes */
+        static const uint8_t FUNC_COUNT = 19;
+        /** @} */
+
+        /** @name   Fields of the status returned by SPI::sd_command()
+         * @{ */
+        /** R1, or 0xff if the card never responded */
+        static const uint32_t SD_R1_BITS = BYTE_0;
+        /** Start token of a read or data-response token of a write, 0xff if
+         *  the card never sent one */
+        static const uint8_t SD_TOKEN_OFFSET = 8;
+        /** Non-zero if the CRC16 of a data block read does not match */
+        static const uint8_t SD_CRC_ERROR_OFFSET = 16;
+        /** @} */
+
+#ifdef SPI_OPTION_STATS
+        /**
+         * @brief   Activity of the SPI cog since the statistics were last reset;
+         *          See SPI::get_stats()
+         *
+         * Cycle counts wrap after 2^32 clock cycles (53 seconds at 80 MHz)
+         */
+        typedef struct {
+            /** Operations executed, indexed by function code */
+            uint32_t calls[SPI::FUNC_COUNT];
+            /** Bits shifted across the bus */
+            uint32_t bits;
+            /** Cycles spent executing operations */
+            uint32_t busyCycles;
+            /** Cycles spent idle, waiting for the mailbox or the descriptor
+             *  ring */
+            uint32_t idleCycles;
+            /** Longest completion latency: the time from handing an
+             *  operation to the SPI cog until a cog waiting on it saw it
+             *  complete, clocking included. Operations that were already
+             *  complete when the wait began are not counted */
+            uint32_t maxCompletionCycles;
+        } Stats;
 #endif
+
+    public:
         /**
          * @brief   Create a new instance of SPI which will, upon calling
          *          SPI::start(), will start a new assembly cog. Creating
@@ -179,20 +300,37 @@ class SPI {
          *          communication
          */
         SPI () {
-            this->m_mailbox = -1;
+            this->m_sequence = 0;
             this->m_cog = -1;
+            this->m_clkDelay = 0;
+            this->m_mosi = PropWare::Port::NULL_PIN;
+            memset(this->m_profiles, 0, sizeof(this->m_profiles));
+            this->m_owner = -1;
+            this->m_ownerDepth = 0;
+            // Without a free hardware lock, the bus is not protected against
+            // concurrent access from multiple cogs
+            this->m_lock = (int8_t) locknew();
+            this->reset_queue();
+        }
+
+        /**
+         * @brief   Stop the SPI cog, if running, and return the hardware lock
+         */
+        ~SPI () {
+            this->stop();
+            if (0 <= this->m_lock)
+                lockret(this->m_lock);
         }
 
-    public:
         /**
-         * @brief   Retrieve an instance of the SPI module
+         * @brief   Retrieve the default SPI bus
          *
          * @return  Address of an SPI module
          */
         static SPI* getInstance () {
-            // TODO: Add a lock to make this thread-safe
-            static SPI instance;
-            return &instance;
+            // The instance is constructed before main() so that two cogs can
+            // not race to construct it
+            return &SPI::s_instance;
         }
 
         /**
@@ -216,6 +354,7 @@ class SPI {
                 const SPI::Mode mode, const SPI::BitMode bitmode) {
             PropWare::ErrorCode err;
             const char str[] = "start";
+            const SPI::Guard guard(this);
 
 #ifdef SPI_OPTION_DEBUG_PARAMS
             // Check clock frequency
@@ -226,25 +365,29 @@ class SPI {
             // If cog already started, do not start another
             if (!this->is_running()) {
 
-                // Start GAS cog
-                // Set the mailbox to 0 (anything other than -1) so that we know
-                // when the SPI cog has started
-                this->m_mailbox = 0;
-                this->m_cog = (int8_t) PropWare::_SPIStartCog((void *) &this->m_mailbox);
+                // Start GAS cog, which reads its pins from the mailbox and then
+                // clears the command to signal that it is running
+                this->reset_queue();
+                this->m_sequence = 0;
+                this->m_mosi = mosi;
+                this->m_mailbox.command = mosi;
+                this->m_mailbox.payload = miso;
+                this->m_mailbox.result = sclk;
+                this->m_mailbox.done = PropWare::Pin::convert(sclk);
+                this->m_cog = (int8_t) PropWare::_SPIStartCog(
+                        (void *) &this->m_mailbox);
                 if (!this->is_running())
                     return SPI::COG_NOT_STARTED;
 
-                // Pass in all parameters
-                check_errors_w_str(this->wait(), str);
-                this->m_mailbox = mosi;
-                check_errors_w_str(this->wait(), str);
-                this->m_mailbox = PropWare::Pin::convert(mosi);
-                check_errors_w_str(this->wait(), str);
-                this->m_mailbox = miso;
-                check_errors_w_str(this->wait(), str);
-                this->m_mailbox = PropWare::Pin::convert(miso);
-                check_errors_w_str(this->wait(), str);
-                this->m_mailbox = sclk;
+                const uint32_t timeoutCnt = SPI::WR_TIMEOUT_VAL + CNT;
+                while (0 != this->m_mailbox.command)
+                    if (abs(timeoutCnt - CNT) < SPI::TIMEOUT_WIGGLE_ROOM) {
+                        this->set_error_method(str);
+                        return SPI::TIMEOUT;
+                    }
+#ifdef SPI_OPTION_STATS
+                this->reset_stats();
+#endif
             }
 
             check_errors_w_str(this->set_mode(mode), str);
@@ -261,12 +404,14 @@ class SPI {
          *          SPI::COG_NOT_STARTED if no cog has previously been started)
          */
         PropWare::ErrorCode stop () {
+            const SPI::Guard guard(this);
+
             if (!this->is_running())
                 return SPI::NO_ERROR;
 
             cogstop(this->m_cog);
             this->m_cog = -1;
-            this->m_mailbox = -1;
+            this->reset_queue();
 
             return SPI::NO_ERROR;
         }
@@ -283,37 +428,18 @@ class SPI {
         /**
          * @brief   Wait for the SPI cog to signal that it is in the idle state
          *
-         * @return  May return non-zero error code when a timeout occurs
-         */
-        PropWare::ErrorCode wait () {
-            const uint32_t timeoutCnt = SPI::WR_TIMEOUT_VAL + CNT;
-
-            // Wait for GAS cog to read in value and write -1
-            while (-1 != this->m_mailbox)
-                if (abs(timeoutCnt - CNT) < SPI::TIMEOUT_WIGGLE_ROOM)
-                    return SPI::TIMEOUT;
-
-            return SPI::NO_ERROR;
-        }
-
-        /**
-         * @brief   Wait for a specific value from the assembly cog
-         *
-         * @param[in]   value   The value being waited on
+         * Any transfers still in the descriptor ring are completed first
          *
          * @return  May return non-zero error code when a timeout occurs
          */
-        PropWare::ErrorCode wait_specific (const uint32_t value) {
-            const uint32_t timeoutCnt = SPI::WR_TIMEOUT_VAL + CNT;
+        PropWare::ErrorCode wait () {
+            PropWare::ErrorCode err;
+            const SPI::Guard guard(this);
 
-            // Wait for GAS cog to read in value and write -1
-            while (value == (uint32_t) this->m_mailbox)
-                if (abs(timeoutCnt - CNT) < SPI::TIMEOUT_WIGGLE_ROOM)
-                    // Always use return instead of spi_error() for private
-                    // f0unctions
-                    return SPI::TIMEOUT;
+            if ((err = this->wait_queue()))
+                return err;
 
-            return SPI::NO_ERROR;
+            return this->wait_done(SPI::WR_TIMEOUT_VAL + CNT);
         }
 
         /**
@@ -327,16 +453,12 @@ class SPI {
         PropWare::ErrorCode set_mode (const SPI::Mode mode) {
             PropWare::ErrorCode err;
             char str[] = "set_mode";
+            const SPI::Guard guard(this);
 
             if (!this->is_running())
                 return SPI::MODULE_NOT_RUNNING;
 
-            // Wait for SPI cog to go idle
-            check_errors_w_str(this->wait(), str);
-
-            this->m_mailbox = SPI::FUNC_SET_MODE;
-            check_errors_w_str(this->wait(), str);
-            this->m_mailbox = mode;
+            check_errors_w_str(this->post(SPI::FUNC_SET_MODE, 0, mode), str);
 
             return SPI::NO_ERROR;
         }
@@ -353,6 +475,7 @@ class SPI {
         PropWare::ErrorCode set_bit_mode (const SPI::BitMode bitmode) {
             PropWare::ErrorCode err;
             char str[] = "set_bit_mode";
+            const SPI::Guard guard(this);
 
             if (!this->is_running())
                 return SPI::MODULE_NOT_RUNNING;
@@ -361,10 +484,8 @@ class SPI {
                 return SPI::INVALID_BITMODE;
 #endif
 
-            check_errors_w_str(this->wait(), str);
-            this->m_mailbox = SPI::FUNC_SET_BITMODE;
-            check_errors_w_str(this->wait(), str);
-            this->m_mailbox = bitmode;
+            check_errors_w_str(this->post(SPI::FUNC_SET_BITMODE, 0, bitmode),
+                    str);
 
             return SPI::NO_ERROR;
         }
@@ -381,6 +502,7 @@ class SPI {
         PropWare::ErrorCode set_clock (const int32_t frequency) {
             PropWare::ErrorCode err;
             char str[] = "set_clock";
+            const SPI::Guard guard(this);
 
             if (!this->is_running())
                 return SPI::MODULE_NOT_RUNNING;
@@ -389,14 +511,260 @@ class SPI {
                 return SPI::INVALID_FREQ;
 #endif
 
-            // Wait for SPI cog to go idle
-            check_errors_w_str(this->wait(), str);
-            // Prepare cog for clock frequency change
-            this->m_mailbox = SPI::FUNC_SET_FREQ;
-            // Wait for the ready command
-            check_errors_w_str(this->wait_specific(SPI::FUNC_SET_FREQ), str);
-            // Send new frequency
-            this->m_mailbox = (CLKFREQ / frequency) >> 1;
+            this->m_clkDelay = (CLKFREQ / frequency) >> 1;
+            check_errors_w_str(
+                    this->post(SPI::FUNC_SET_FREQ, 0, this->m_clkDelay), str);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Clock block and sector transfers with the cog's counter
+         *              module instead of toggling SCLK in software
+         *
+         * When enabled, SPI::shift_out_block(), SPI::shift_in_block() and the
+         * data blocks of SPI::sd_command() run SCLK at a fixed CLKFREQ/8 (10 MHz at
+         * 80 MHz) regardless of SPI::set_clock(); the peripheral must be able
+         * to keep up with that rate. Reads in modes with data valid after the
+         * clock (SPI::MODE_1 and SPI::MODE_3) continue to be bit-banged.
+         * Single-word transfers are unaffected
+         *
+         * @param[in]   enabled     True to clock block transfers with the
+         *                          counter module, false to bit-bang SCLK
+         *
+         * @return      Can return non-zero in the case of a timeout
+         */
+        PropWare::ErrorCode set_counter_clock (const bool enabled) {
+            PropWare::ErrorCode err;
+            char str[] = "set_counter_clock";
+            const SPI::Guard guard(this);
+
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+
+            check_errors_w_str(this->post(SPI::FUNC_SET_CTR_CLK, 0, enabled),
+                    str);
+
+            return SPI::NO_ERROR;
+        }
+
+#ifdef SPI_OPTION_VIDEO
+        /**
+         * @brief       Transmit blocks with the cog's video generator, with
+         *              SCLK at CLKFREQ/4 (20 MHz at 80 MHz)
+         *
+         * SPI::shift_out_block() and the data blocks written by
+         * SPI::sd_command() are handed to the video generator 32 bits at a
+         * time, so the bus does not pause between bytes. Every mode and bit
+         * order is supported; the CRC16 of an SD sector is computed before the
+         * sector is sent. Reads are clocked by the counter module, just as
+         * with SPI::set_counter_clock().
+         *
+         * Blocks whose hub address or length is not a multiple of four are
+         * bit-banged at the device's own clock instead. So are all blocks when
+         * the system clock is outside of the range of the PLL feeding the video
+         * generator (64 MHz to 128 MHz).
+         *
+         * @note    Replaces the counter-clocked transmit path: with
+         *          SPI_OPTION_VIDEO, SPI::set_counter_clock() only speeds up
+         *          reads
+         *
+         * @param[in]   enabled     True to transmit blocks with the video
+         *                          generator, false to bit-bang SCLK
+         *
+         * @return      Can return non-zero in the case of a timeout
+         */
+        PropWare::ErrorCode set_video_transmit (const bool enabled) {
+            PropWare::ErrorCode err;
+            char str[] = "set_video_transmit";
+            const SPI::Guard guard(this);
+            uint32_t config = enabled;
+
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+
+            if (enabled && SPI::VIDEO_MIN_CLKFREQ <= CLKFREQ
+                    && SPI::VIDEO_MAX_CLKFREQ >= CLKFREQ)
+                config = SPI::video_config(this->m_mosi);
+
+            check_errors_w_str(this->post(SPI::FUNC_SET_CTR_CLK, 0, config),
+                    str);
+
+            return SPI::NO_ERROR;
+        }
+#endif
+
+        /**
+         * @brief       Register a device profile with the SPI cog
+         *
+         * A profile bundles the chip select pin and communication settings of
+         * one device on the bus. SPI::select() switches the SPI cog to those
+         * settings and asserts chip select without any further calls from C.
+         * The SPI cog takes ownership of the chip select pin (active low),
+         * which must therefore not be driven by any other cog. Chip select is
+         * driven high right away; The settings of the bus are left alone until
+         * the profile is selected. A profile can not be modified once
+         * registered, but it can be removed with SPI::remove_profile()
+         *
+         * @param[in]   cs          Pin mask for the device's chip select
+         * @param[in]   mode        SPI mode used by the device
+         * @param[in]   bitmode     Bit order used by the device
+         * @param[in]   frequency   Frequency, in Hz, to run the SPI clock for
+         *                          the device; See SPI::set_clock()
+         * @param[out]  *id         Identifies the new profile
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode add_profile (const PropWare::Port::Mask cs,
+                const SPI::Mode mode, const SPI::BitMode bitmode,
+                const int32_t frequency, SPI::ProfileId *id) {
+            PropWare::ErrorCode err;
+            char str[] = "add_profile";
+            SPI::Profile *profile;
+            const SPI::Guard guard(this);
+
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (SPI::MAX_CLOCK <= frequency || 0 >= frequency)
+                return SPI::INVALID_FREQ;
+            if (SPI::MODE_3 < mode)
+                return SPI::INVALID_MODE;
+            if (SPI::LSB_FIRST != bitmode && SPI::MSB_FIRST != bitmode)
+                return SPI::INVALID_BITMODE;
+#endif
+
+            // Take the first free slot; A free slot has no chip select
+            for (profile = this->m_profiles; profile->csMask; ++profile)
+                if (&this->m_profiles[SPI::MAX_PROFILES - 1] == profile)
+                    return SPI::TOO_MANY_PROFILES;
+            profile->csMask = cs;
+            profile->mode = mode;
+            profile->bitMode = bitmode;
+            profile->clkDelay = (CLKFREQ / frequency) >> 1;
+            *id = (SPI::ProfileId) (profile - this->m_profiles + 1);
+
+            // Let the SPI cog drive chip select high right away
+            check_errors_w_str(
+                    this->enqueue(SPI::FUNC_DESELECT, *id, 0, 0, NULL), str);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Remove a device profile, freeing its slot for another
+         *
+         * The SPI cog keeps driving the chip select pin high until it is
+         * stopped, so the device stays deselected
+         *
+         * @pre         The profile must not be selected
+         *
+         * @param[in]   id      Profile returned by SPI::add_profile()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode remove_profile (const SPI::ProfileId id) {
+            PropWare::ErrorCode err;
+            char str[] = "remove_profile";
+            SPI::Ticket ticket;
+            const SPI::Guard guard(this);
+
+            if (!this->is_profile(id))
+                return SPI::INVALID_PROFILE;
+
+            // Deselect the device one last time, which also makes the SPI cog
+            // forget the profile's settings if they are loaded. Once that is
+            // done, a new profile can safely take over the slot
+            check_errors_w_str(
+                    this->enqueue(SPI::FUNC_DESELECT, id, 0, 0, &ticket), str);
+            check_errors_w_str(this->wait_for(ticket), str);
+            this->m_profiles[id - 1].csMask = 0;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Take ownership of the bus and queue the selection of a
+         *              device: the SPI cog loads the profile's settings (if not
+         *              already loaded) and asserts its chip select
+         *
+         * The calling cog owns the bus until the matching call to
+         * SPI::deselect(); Other cogs block in their next call to this module
+         * until then. Settings changed through SPI::set_mode(),
+         * SPI::set_bit_mode() or SPI::set_clock() are overridden by the next
+         * selection
+         *
+         * @param[in]   id      Profile returned by SPI::add_profile()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode select (const SPI::ProfileId id) {
+            PropWare::ErrorCode err;
+
+            if (!this->is_profile(id))
+                return SPI::INVALID_PROFILE;
+
+            this->lock();
+
+            // Timeouts of subsequent transfers are based on this profile
+            this->m_clkDelay = this->m_profiles[id - 1].clkDelay;
+            if ((err = this->enqueue(SPI::FUNC_SELECT, id, 0, 0, NULL)))
+                this->unlock();
+
+            return err;
+        }
+
+        /**
+         * @brief       Queue the deassertion of a device's chip select and
+         *              release the bus taken by SPI::select()
+         *
+         * Like all queued transfers, this does not wait for the SPI cog; Call
+         * SPI::wait() if the bus must be idle upon return
+         *
+         * @param[in]   id      Profile returned by SPI::add_profile()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode deselect (const SPI::ProfileId id) {
+            PropWare::ErrorCode err;
+
+            if (!this->is_profile(id))
+                return SPI::INVALID_PROFILE;
+            if (cogid() != this->m_owner)
+                return SPI::NOT_BUS_OWNER;
+
+            // The bus is released even if chip select could not be queued so
+            // that an error can not starve every other cog
+            err = this->enqueue(SPI::FUNC_DESELECT, id, 0, 0, NULL);
+            this->unlock();
+
+            return err;
+        }
+
+        /**
+         * @brief   Take ownership of the bus, blocking while another cog owns
+         *          it
+         *
+         * Use this for transactions that do not use a device profile, such as
+         * those with a chip select driven by the calling cog. Calls may be
+         * nested; The bus is released by the outermost SPI::unlock()
+         */
+        void lock () {
+            this->acquire();
+            ++this->m_ownerDepth;
+        }
+
+        /**
+         * @brief   Release ownership of the bus taken by SPI::lock()
+         *
+         * @return  Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode unlock () {
+            if (cogid() != this->m_owner || 0 == this->m_ownerDepth)
+                return SPI::NOT_BUS_OWNER;
+
+            if (0 == --this->m_ownerDepth)
+                this->release();
 
             return SPI::NO_ERROR;
         }
@@ -412,6 +780,7 @@ class SPI {
         PropWare::ErrorCode get_clock (int32_t *frequency) {
             PropWare::ErrorCode err;
             char str[] = "get_clock";
+            const SPI::Guard guard(this);
 
 #ifdef SPI_OPTION_DEBUG_PARAMS
             // Check for errors
@@ -419,14 +788,10 @@ class SPI {
                 return SPI::MODULE_NOT_RUNNING;
 #endif
 
-            // Wait to ensure the SPI cog is in its idle state
-            check_errors_w_str(this->wait(), str);
-
-            // Call GAS function
-            this->m_mailbox = SPI::FUNC_GET_FREQ;
-            check_errors_w_str(this->wait_specific(SPI::FUNC_GET_FREQ), str);
-
-            this->read_par(frequency, sizeof(*frequency));
+            check_errors_w_str(this->post(SPI::FUNC_GET_FREQ, 0, 0), str);
+            check_errors_w_str(
+                    this->read_result(frequency, sizeof(*frequency),
+                            SPI::WR_TIMEOUT_VAL + CNT), str);
             *frequency = CLKFREQ / (*frequency << 1);
 
             return SPI::NO_ERROR;
@@ -435,10 +800,11 @@ class SPI {
         /**
          * @brief       Send a value out to a peripheral device
          *
-         * Pass a value and mode into the assembly cog to be sent to the
-         * peripheral; NOTE: this function is non-blocking and chip-select
-         * should not be set inactive immediately after the return (you should
-         * call spi_wait() before setting chip-select inactive)
+         * The send is posted: it returns as soon as the value is in the
+         * descriptor ring, so consecutive sends queue up behind one another
+         * while the caller carries on. Reads and SPI::deselect() are ordered
+         * behind it, but a chip select driven by the caller must not be set
+         * inactive before SPI::fence() returns
          *
          * @param[in]   bits        Number of bits to be shifted out
          * @param[in]   value       The value to be shifted out
@@ -457,19 +823,10 @@ class SPI {
                 return SPI::TOO_MANY_BITS;
 #endif
 
-            // Wait to ensure the SPI cog is in its idle state
-            check_errors_w_str(this->wait(), str);
-
-            // Call GAS function
-            this->m_mailbox = SPI::FUNC_SEND | (bits << SPI::BITS_OFFSET);
+            // The descriptor ring is drained in order, so there is no need to
+            // wait for the SPI cog to go idle
             check_errors_w_str(
-                    this->wait_specific(
-                            SPI::FUNC_SEND | (bits << SPI::BITS_OFFSET)), str);
-
-            // Pass parameter in; Bit 31 is cleared to indicate data is being
-            // sent. Without this limitation, who's to say the value being
-            // passed is not -1?
-            this->m_mailbox = value & (~BIT_31);
+                    this->enqueue(SPI::FUNC_SEND, bits, value, 0, NULL), str);
 
             return SPI::NO_ERROR;
         }
@@ -492,6 +849,9 @@ class SPI {
                 const size_t size) {
             PropWare::ErrorCode err;
             const char str[] = "shift_in";
+            SPI::Ticket ticket;
+            uint32_t in;
+            const SPI::Guard guard(this);
 
             // Check for errors
 #ifdef SPI_OPTION_DEBUG_PARAMS
@@ -499,135 +859,662 @@ class SPI {
                 return SPI::MODULE_NOT_RUNNING;
             if (SPI::MAX_PAR_BITS < bits)
                 return SPI::TOO_MANY_BITS;
-            if ((4 == size && ((uint32_t) data) % 4)
-                    || (2 == size && ((uint32_t) data) % 2))
+            if ((4 == size && ((uintptr_t) data) % 4)
+                    || (2 == size && ((uintptr_t) data) % 2))
                 return SPI::ADDR_MISALIGN;
 #endif
 
-            // Ensure SPI module is not busy
-            check_errors_w_str(this->wait(), str);
-
-            // Call GAS function
-            this->m_mailbox = SPI::FUNC_READ | (bits << SPI::BITS_OFFSET);
+            check_errors_w_str(this->submit_shift_in(bits, &ticket), str);
+            check_errors_w_str(this->wait_for(ticket, &in), str);
 
-            // Read in parameter
-            check_errors_w_str(this->read_par(data, size), str);
+            switch (size) {
+                case sizeof(uint8_t):
+                    *((uint8_t *) data) = (uint8_t) in;
+                    break;
+                case sizeof(uint16_t):
+                    *((uint16_t *) data) = (uint16_t) in;
+                    break;
+                case sizeof(uint32_t):
+                    *((uint32_t *) data) = in;
+                    break;
+                default:
+                    return SPI::INVALID_BYTE_SIZE;
+            }
 
             return SPI::NO_ERROR;
         }
 
-#ifdef SPI_OPTION_FAST
         /**
-         * @brief       Send a value out to a peripheral device
+         * @brief       Send an entire buffer out to a peripheral device
          *
-         * Pass a value and mode into the assembly cog to be sent to the 
-         * peripheral; NOTE: this function is non-blocking and chip-select 
-         * should not be set inactive immediately after the return (you should 
-         * call spi_wait() before setting chip-select inactive); Optimized for 
-         * fastest possible clock speed; No error checking is performed; 
-         * 'Timeout' event will never be thrown and possible infinite loop can 
-         * happen
+         * The buffer is handed to the SPI cog in a single transfer descriptor
+         * and the cog streams every byte without any further handshaking. The
+         * current mode and bitmode are used for each byte. Unlike
+         * SPI::shift_out(), this function does not return until the last byte
+         * has been shifted out, so chip-select may be set inactive
+         * immediately afterward
          *
-         * @param[in]   bits        Number of bits to be shifted out
-         * @param[in]   value       The value to be shifted out
+         * @param[in]   buffer[]        Hub address of the first byte to send
+         * @param[in]   numberOfBytes   Number of bytes to be shifted out
          *
          * @return      Returns 0 upon success, otherwise error code
          */
-        PropWare::ErrorCode shift_out_fast (uint8_t bits, uint32_t value) {
-            // NOTE: No debugging within this function to allow for fastest
-            // possible execution time
-            // Wait to ensure the SPI cog is in its idle state
-            this->wait();
+        PropWare::ErrorCode shift_out_block (const uint8_t buffer[],
+                const size_t numberOfBytes) {
+            PropWare::ErrorCode err;
+            const char str[] = "shift_out_block";
+            SPI::Ticket ticket;
+            const SPI::Guard guard(this);
 
-            // Call GAS function
-            this->m_mailbox = PropWare::SPI::FUNC_SEND_FAST
-                    | (bits << PropWare::SPI::BITS_OFFSET);
-            this->wait();
+            if (!numberOfBytes)
+                return SPI::NO_ERROR;
 
-            // Pass parameter in; Bit 31 is cleared to indicate data is being
-            // sent. Without this limitation, who's to say the value being
-            // passed is not -1?
-            this->m_mailbox = value & (~BIT_31);
+            check_errors_w_str(
+                    this->submit_shift_out_block(buffer, numberOfBytes, &ticket),
+                    str);
+            check_errors_w_str(this->wait_for(ticket), str);
 
-            return PropWare::SPI::NO_ERROR;
+            return SPI::NO_ERROR;
         }
 
         /**
-         * @brief       Quickly receive a value in from a peripheral device
+         * @brief       Receive an entire buffer in from a peripheral device
          *
-         * Optimized for fastest possible clock speed; No error checking is
-         * performed; 'Timeout' event will never be thrown and possible infinite
-         * loop can happen
+         * The buffer is handed to the SPI cog in a single transfer descriptor
+         * and the cog writes every byte directly to hub RAM, signaling only once
+         * the entire buffer is full. The current mode and bitmode are used for
+         * each byte
          *
-         * @param[in]   bits    Number of bits to be shifted in
-         * @param[out]  *data   Received data will be stored at this address
-         * @param[in]   bytes   Number of bytes allocated to *data; Example:
-         *                        int newVal;
-         *                        spi.shift_in_fast(8, &newVal, sizeof(newVal));
-         *                      Or if using a pointer:
-         *                        int *newVal;
-         *                        spi.shift_in_fast(8, newVal, sizeof(*newVal));
+         * @param[out]  buffer[]        Hub address where the first byte should
+         *                              be written
+         * @param[in]   numberOfBytes   Number of bytes to be shifted in
+         *
+         * @return      Returns 0 upon success, otherwise error code
          */
-        PropWare::ErrorCode shift_in_fast (const uint8_t bits, void *data,
-                const uint8_t bytes) {
-            uint8_t *par8;
-            uint16_t *par16;
-            uint32_t *par32;
-
-            // Wait until idle state, then send function and mode bits
-            this->wait();
-            this->m_mailbox = PropWare::SPI::FUNC_READ_FAST
-                    | (bits << PropWare::SPI::BITS_OFFSET);
-
-            // Wait for a value to be written
-            while (-1 == this->m_mailbox)
-                waitcnt(PropWare::SPI::TIMEOUT_WIGGLE_ROOM + CNT);
+        PropWare::ErrorCode shift_in_block (uint8_t buffer[],
+                const size_t numberOfBytes) {
+            PropWare::ErrorCode err;
+            const char str[] = "shift_in_block";
+            SPI::Ticket ticket;
+            const SPI::Guard guard(this);
 
-            // Determine if output variable is char, short or long and write
-            // data to that location
-            switch (bytes) {
-                case sizeof(uint8_t):
-                    par8 = (uint8_t *) data;
-                    *par8 = (uint8_t) this->m_mailbox;
-                    break;
-                case sizeof(uint16_t):
-                    par16 = (uint16_t *) data;
-                    *par16 = (uint16_t) this->m_mailbox;
-                    break;
-                case sizeof(uint32_t):
-                    par32 = (uint32_t *) data;
-                    *par32 = (uint32_t) this->m_mailbox;
-                    break;
-                default:
-                    return PropWare::SPI::INVALID_BYTE_SIZE;
-            }
+            if (!numberOfBytes)
+                return SPI::NO_ERROR;
 
-            // Signal that value is saved and GAS cog can continue execution
-            this->m_mailbox = -1;
+            check_errors_w_str(
+                    this->submit_shift_in_block(buffer, numberOfBytes, &ticket),
+                    str);
+            check_errors_w_str(this->wait_for(ticket), str);
 
-            return PropWare::SPI::NO_ERROR;
+            return SPI::NO_ERROR;
         }
 
         /**
-         * @brief       Read an entire sector of data in from an SD card
+         * @brief       Send and receive a value simultaneously
+         *
+         * MOSI is driven and MISO is sampled within the same clock period;
+         * MISO is read just ahead of the trailing edge, which is valid for
+         * both clock phases. Does not return until the exchange is complete
+         *
+         * @param[in]   bits    Number of bits to be exchanged
+         * @param[in]   out     The value to be shifted out
+         * @param[out]  *in     The value shifted in is stored here
          *
-         * @param[out]  *addr       First hub address where the data should be
-         *                          written
-         * @param[in]   blocking    When set to non-zero, function will not
-         *                          return until the data transfer is complete
+         * @return      Returns 0 upon success, otherwise error code
          */
-        PropWare::ErrorCode shift_in_sector (const uint8_t addr[],
-                const uint8_t blocking) {
-            this->wait();
-            this->m_mailbox = PropWare::SPI::FUNC_READ_SECTOR;
-            this->wait();
-            this->m_mailbox = (uint32_t) addr;
-            if (blocking)
-                return this->wait();
-            else
-                return PropWare::SPI::NO_ERROR;
+        PropWare::ErrorCode transfer (const uint8_t bits, const uint32_t out,
+                uint32_t *in) {
+            PropWare::ErrorCode err;
+            const char str[] = "transfer";
+            SPI::Ticket ticket;
+            const SPI::Guard guard(this);
+
+            check_errors_w_str(this->submit_transfer(bits, out, &ticket), str);
+            check_errors_w_str(this->wait_for(ticket, in), str);
+
+            return SPI::NO_ERROR;
         }
-#endif
+
+        /**
+         * @brief       Exchange an entire buffer with a peripheral device
+         *
+         * Each byte of the buffer is shifted out and replaced by the byte
+         * shifted in during the same eight clocks. SCLK is always bit-banged,
+         * even when SPI::set_counter_clock() is enabled. Does not return until
+         * the last byte has been exchanged
+         *
+         * @param[in,out]   buffer[]        Bytes to be sent; Overwritten with
+         *                                  the bytes received
+         * @param[in]       numberOfBytes   Number of bytes in the buffer
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode transfer_block (uint8_t buffer[],
+                const size_t numberOfBytes) {
+            PropWare::ErrorCode err;
+            const char str[] = "transfer_block";
+            SPI::Ticket ticket;
+            const SPI::Guard guard(this);
+
+            if (!numberOfBytes)
+                return SPI::NO_ERROR;
+
+            check_errors_w_str(
+                    this->submit_transfer_block(buffer, numberOfBytes, &ticket),
+                    str);
+            check_errors_w_str(this->wait_for(ticket), str);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Send a value to several devices at once while receiving
+         *              from all of them simultaneously
+         *
+         * Every device shares MOSI and SCLK but drives its own MISO pin. The
+         * SPI cog samples all MISO pins with a single read of INA on each
+         * clock and collects every device's bits in its own registers, so
+         * every device is read in phase for the cost of one transfer. Bits
+         * are sampled as SPI::transfer() samples them and are always shifted
+         * MSB first. SCLK runs at the frequency set, up to CLKFREQ/128
+         *
+         * @param[in]       bits        Number of bits to be exchanged
+         * @param[in]       out         The value to be shifted out
+         * @param[in,out]   channels[]  MISO pin mask of each device; The bits
+         *                              received from each device are stored
+         *                              alongside its mask
+         * @param[in]       count       Number of devices; At most
+         *                              SPI::MAX_GANG_CHANNELS
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode gang_transfer (const uint8_t bits,
+                const uint32_t out, SPIBus::GangChannel channels[],
+                const uint8_t count) {
+            PropWare::ErrorCode err;
+            const char str[] = "gang_transfer";
+            SPI::Ticket ticket;
+            const SPI::Guard guard(this);
+
+            if (!count)
+                return SPI::NO_ERROR;
+
+            check_errors_w_str(
+                    this->submit_gang_transfer(bits, out, channels, count,
+                            &ticket), str);
+            check_errors_w_str(this->wait_for(ticket), str);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Execute an SD card command from start to finish in a
+         *              single call
+         *
+         * The SPI cog waits for the card to release MISO after any write,
+         * sends the command frame, polls for R1 and receives the rest of the
+         * response. If the card accepted the command (R1 is zero) and a data
+         * phase was requested, the cog then waits for the start token and
+         * reads the data block and its CRC16, or sends the start token, the
+         * data block and its CRC16 and waits for the data-response token. The
+         * CRC16 is computed as the data streams through the cog. Each wait
+         * gives up after SPI::SDCommand::timeout clock cycles. Chip select must
+         * already be asserted
+         *
+         * @param[in]   *command    The command; Must stay in place, long
+         *                          aligned, until this call returns
+         * @param[out]  *status     R1, the token and the CRC check; See
+         *                          SPI::SD_R1_BITS and friends
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode sd_command (SPI::SDCommand *command,
+                uint32_t *status) {
+            PropWare::ErrorCode err;
+            const char str[] = "sd_command";
+            const SPI::Guard guard(this);
+
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if ((uintptr_t) command & 3)
+                return SPI::ADDR_MISALIGN;
+#endif
+
+            check_errors_w_str(
+                    this->post(SPI::FUNC_SD_COMMAND, 0, (uintptr_t) command,
+                            command->length), str);
+
+            // Each of the cog's waits may run for the full timeout before the
+            // frame and data block are shifted
+            check_errors_w_str(
+                    this->read_result(status, sizeof(*status),
+                            SPI::WR_TIMEOUT_VAL + CNT
+                                    + SPI::SD_WAITS * command->timeout
+                                    + (SPI::SD_FRAME_BYTES + command->length)
+                                            * ((this->m_clkDelay << 4)
+                                                    + SPI::BLOCK_BYTE_OVERHEAD)),
+                    str);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Pack the fixed part of an SD card command for
+         *              SPI::SDCommand::frame
+         *
+         * @param[in]   cmd             Command byte, including the start and
+         *                              transmission bits
+         * @param[in]   crc             CRC7 byte, including the end bit
+         * @param[in]   phase           Data block transferred after the
+         *                              response
+         * @param[in]   responseLength  Number of bytes in the response,
+         *                              including R1; No more than five
+         */
+        static uint32_t sd_frame (const uint8_t cmd, const uint8_t crc,
+                const SPI::SDPhase phase, const uint8_t responseLength) {
+            return cmd | (crc << SPI::SD_CRC_OFFSET)
+                    | ((uint32_t) phase << SPI::SD_PHASE_OFFSET)
+                    | ((uint32_t) ((responseLength - 1) << 3)
+                            << SPI::SD_RESPONSE_BITS_OFFSET);
+        }
+
+        /**
+         * @brief       Queue a value to be sent to a peripheral device
+         *
+         * Returns as soon as the transfer is in the descriptor ring, blocking
+         * only while the ring is full. Transfers are executed in the order they
+         * were submitted, interleaved with nothing but mailbox calls that begin
+         * by draining the ring
+         *
+         * @param[in]   bits        Number of bits to be shifted out
+         * @param[in]   value       The value to be shifted out
+         * @param[out]  *ticket     If not NULL, identifies the transfer for
+         *                          SPI::poll() and SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_shift_out (const uint8_t bits,
+                const uint32_t value, SPI::Ticket *ticket = NULL) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (32 < bits)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            return this->enqueue(SPI::FUNC_SEND, bits, value, 0, ticket);
+        }
+
+        /**
+         * @brief       Queue a value to be received from a peripheral device
+         *
+         * The received value is retrieved with SPI::poll() or SPI::wait_for()
+         *
+         * @param[in]   bits        Number of bits to be shifted in
+         * @param[out]  *ticket     Identifies the transfer for SPI::poll() and
+         *                          SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_shift_in (const uint8_t bits,
+                SPI::Ticket *ticket) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (SPI::MAX_PAR_BITS < bits)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            return this->enqueue(SPI::FUNC_READ, bits, 0, 0, ticket);
+        }
+
+        /**
+         * @brief       Queue a value to be exchanged with a peripheral device
+         *
+         * The received value is retrieved with SPI::poll() or SPI::wait_for();
+         * See SPI::transfer()
+         *
+         * @param[in]   bits        Number of bits to be exchanged
+         * @param[in]   out         The value to be shifted out
+         * @param[out]  *ticket     Identifies the transfer for SPI::poll() and
+         *                          SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_transfer (const uint8_t bits,
+                const uint32_t out, SPI::Ticket *ticket) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (32 < bits)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            return this->enqueue(SPI::FUNC_TRANSFER, bits, out, 0, ticket);
+        }
+
+        /**
+         * @brief       Queue an entire buffer to be sent to a peripheral device
+         *
+         * The buffer must not be modified until the transfer has completed
+         *
+         * @param[in]   buffer[]        Bytes to be sent
+         * @param[in]   numberOfBytes   Number of bytes in the buffer; Must be
+         *                              non-zero
+         * @param[out]  *ticket         If not NULL, identifies the transfer for
+         *                              SPI::poll() and SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_shift_out_block (const uint8_t buffer[],
+                const size_t numberOfBytes, SPI::Ticket *ticket = NULL) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (0 == numberOfBytes)
+                return SPI::INVALID_BYTE_SIZE;
+#endif
+
+            return this->enqueue(SPI::FUNC_SEND_BLOCK, 8, (uintptr_t) buffer,
+                    numberOfBytes, ticket);
+        }
+
+        /**
+         * @brief       Queue an entire buffer to be received from a peripheral
+         *              device
+         *
+         * The buffer must not be read until the transfer has completed
+         *
+         * @param[out]  buffer[]        Received bytes will be stored here
+         * @param[in]   numberOfBytes   Number of bytes to receive; Must be
+         *                              non-zero
+         * @param[out]  *ticket         If not NULL, identifies the transfer for
+         *                              SPI::poll() and SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_shift_in_block (uint8_t buffer[],
+                const size_t numberOfBytes, SPI::Ticket *ticket = NULL) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (0 == numberOfBytes)
+                return SPI::INVALID_BYTE_SIZE;
+#endif
+
+            return this->enqueue(SPI::FUNC_READ_BLOCK, 8, (uintptr_t) buffer,
+                    numberOfBytes, ticket);
+        }
+
+        /**
+         * @brief       Queue an entire buffer to be exchanged with a peripheral
+         *              device
+         *
+         * The buffer must not be accessed until the transfer has completed;
+         * See SPI::transfer_block()
+         *
+         * @param[in,out]   buffer[]        Bytes to be sent; Overwritten with
+         *                                  the bytes received
+         * @param[in]       numberOfBytes   Number of bytes in the buffer; Must
+         *                                  be non-zero
+         * @param[out]      *ticket         If not NULL, identifies the transfer
+         *                                  for SPI::poll() and SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_transfer_block (uint8_t buffer[],
+                const size_t numberOfBytes, SPI::Ticket *ticket = NULL) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (0 == numberOfBytes)
+                return SPI::INVALID_BYTE_SIZE;
+#endif
+
+            return this->enqueue(SPI::FUNC_TRANSFER_BLOCK, 8,
+                    (uintptr_t) buffer, numberOfBytes, ticket);
+        }
+
+        /**
+         * @brief       Queue a value to be exchanged with several devices at
+         *              once
+         *
+         * The channels must not be accessed until the transfer has completed;
+         * See SPI::gang_transfer()
+         *
+         * @param[in]       bits        Number of bits to be exchanged
+         * @param[in]       out         The value to be shifted out
+         * @param[in,out]   channels[]  MISO pin mask of each device; The bits
+         *                              received from each device are stored
+         *                              alongside its mask
+         * @param[in]       count       Number of devices; Must be non-zero and
+         *                              at most SPI::MAX_GANG_CHANNELS
+         * @param[out]      *ticket     If not NULL, identifies the transfer
+         *                              for SPI::poll() and SPI::wait_for()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode submit_gang_transfer (const uint8_t bits,
+                const uint32_t out, SPIBus::GangChannel channels[],
+                const uint8_t count, SPI::Ticket *ticket = NULL) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+            if (32 < bits)
+                return SPI::TOO_MANY_BITS;
+            if (0 == count)
+                return SPI::INVALID_BYTE_SIZE;
+#endif
+
+            // Checked regardless, as the SPI cog has registers for no more
+            if (SPI::MAX_GANG_CHANNELS < count)
+                return SPI::TOO_MANY_CHANNELS;
+
+            // The SPI cog loads each channel's bits along with its mask and
+            // shifts each received bit in above the bits before it
+            for (uint8_t i = 0; i < count; ++i)
+                channels[i].data = 0;
+
+            return this->enqueue(
+                    SPI::FUNC_GANG_TRANSFER
+                            | (count << SPI::GANG_COUNT_OFFSET), bits, out,
+                    (uintptr_t) channels, ticket);
+        }
+
+        /**
+         * @brief       Determine whether a queued transfer has completed
+         *
+         * @param[in]   ticket  Transfer returned by one of the submit methods
+         * @param[out]  *data   If not NULL and the transfer has completed, the
+         *                      received value is stored here; Only valid for
+         *                      SPI::submit_shift_in() and
+         *                      SPI::submit_transfer(), and only until
+         *                      SPI::QUEUE_LENGTH more transfers are submitted
+         *
+         * @return      True if the transfer has completed
+         */
+        bool poll (const SPI::Ticket ticket, uint32_t *data = NULL) const {
+            const SPI::Descriptor *slot = this->get_slot(ticket);
+
+            // Slots are only reused once retired, so an overwritten slot
+            // implies completion
+            if (SPI::QUEUE_LENGTH < this->m_submitted - ticket)
+                return true;
+
+            if (SPI::QUEUE_PENDING & slot->op)
+                return false;
+
+            if (NULL != data)
+                *data = (uint32_t) slot->data;
+            return true;
+        }
+
+        /**
+         * @brief       Wait for a queued transfer to complete
+         *
+         * @param[in]   ticket  Transfer returned by one of the submit methods
+         * @param[out]  *data   If not NULL, the received value is stored here;
+         *                      See SPI::poll()
+         *
+         * @return      May return non-zero error code when a timeout occurs
+         */
+        PropWare::ErrorCode wait_for (const SPI::Ticket ticket,
+                uint32_t *data = NULL) {
+            const uint32_t timeoutCnt = this->get_queue_timeout(
+                    this->get_slot(ticket));
+
+            if (this->poll(ticket, data))
+                return SPI::NO_ERROR;
+
+            while (!this->poll(ticket, data))
+                if (abs(timeoutCnt - CNT) < SPI::TIMEOUT_WIGGLE_ROOM)
+                    return SPI::TIMEOUT;
+            this->count_completion(ticket % SPI::QUEUE_LENGTH);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Wait for every posted send, and any other queued transfer,
+         *          to complete; Unlike SPI::wait(), mailbox calls are not
+         *          waited on
+         *
+         * @return  May return non-zero error code when a timeout occurs
+         */
+        PropWare::ErrorCode fence () {
+            PropWare::ErrorCode err;
+            const char str[] = "fence";
+            const SPI::Guard guard(this);
+
+            check_errors_w_str(this->wait_queue(), str);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Wait for every queued transfer to complete
+         *
+         * @return  May return non-zero error code when a timeout occurs
+         */
+        PropWare::ErrorCode wait_queue () {
+            // Descriptors are executed in order: the ring is empty once the
+            // most recent one is retired
+            if (0 == this->m_submitted)
+                return SPI::NO_ERROR;
+            return this->wait_for(this->m_submitted - 1);
+        }
+
+#ifdef SPI_OPTION_STATS
+        /**
+         * @brief       Retrieve the activity of the SPI cog since SPI::start()
+         *              or the last call to SPI::reset_stats()
+         *
+         * Operations still in the descriptor ring are counted but their
+         * cycles are not
+         *
+         * @param[out]  *stats  Statistics are copied here
+         */
+        void get_stats (SPI::Stats *stats) {
+            const SPI::Guard guard(this);
+
+            *stats = this->m_stats;
+            stats->busyCycles = this->m_cogStats.busyCycles;
+            stats->idleCycles = CNT - this->m_statsStart - stats->busyCycles;
+        }
+
+        /**
+         * @brief   Clear all statistics; Waits for every queued transfer and
+         *          any operation still in the mailbox to complete first so
+         *          that none is counted twice
+         */
+        void reset_stats () {
+            const SPI::Guard guard(this);
+
+            this->wait();
+            memset(&this->m_stats, 0, sizeof(this->m_stats));
+            this->m_cogStats.busyCycles = 0;
+            this->m_statsStart = CNT;
+        }
+#endif
+
+#ifdef SPI_OPTION_FAST
+        /**
+         * @brief       Send a value out to a peripheral device
+         *
+         * Pass a value and mode into the assembly cog to be sent to the 
+         * peripheral; NOTE: this function is non-blocking and chip-select 
+         * should not be set inactive immediately after the return (you should 
+         * call spi_wait() before setting chip-select inactive); Optimized for 
+         * fastest possible clock speed; No error checking is performed; 
+         * 'Timeout' event will never be thrown and possible infinite loop can 
+         * happen
+         *
+         * @param[in]   bits        Number of bits to be shifted out
+         * @param[in]   value       The value to be shifted out
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode shift_out_fast (uint8_t bits, uint32_t value) {
+            const SPI::Guard guard(this);
+
+            // NOTE: No debugging within this function to allow for fastest
+            // possible execution time
+            this->post(SPI::FUNC_SEND_FAST, bits, value);
+
+            return PropWare::SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Quickly receive a value in from a peripheral device
+         *
+         * Optimized for fastest possible clock speed; No error checking is
+         * performed; 'Timeout' event will never be thrown and possible infinite
+         * loop can happen
+         *
+         * @param[in]   bits    Number of bits to be shifted in
+         * @param[out]  *data   Received data will be stored at this address
+         * @param[in]   bytes   Number of bytes allocated to *data; Example:
+         *                        int newVal;
+         *                        spi.shift_in_fast(8, &newVal, sizeof(newVal));
+         *                      Or if using a pointer:
+         *                        int *newVal;
+         *                        spi.shift_in_fast(8, newVal, sizeof(*newVal));
+         */
+        PropWare::ErrorCode shift_in_fast (const uint8_t bits, void *data,
+                const uint8_t bytes) {
+            uint8_t *par8;
+            uint16_t *par16;
+            uint32_t *par32;
+            const SPI::Guard guard(this);
+
+            this->post(SPI::FUNC_READ_FAST, bits, 0);
+            while (this->m_sequence != this->m_mailbox.done)
+                ;
+
+            // Determine if output variable is char, short or long and write
+            // data to that location
+            switch (bytes) {
+                case sizeof(uint8_t):
+                    par8 = (uint8_t *) data;
+                    *par8 = (uint8_t) this->m_mailbox.result;
+                    break;
+                case sizeof(uint16_t):
+                    par16 = (uint16_t *) data;
+                    *par16 = (uint16_t) this->m_mailbox.result;
+                    break;
+                case sizeof(uint32_t):
+                    par32 = (uint32_t *) data;
+                    *par32 = this->m_mailbox.result;
+                    break;
+                default:
+                    return PropWare::SPI::INVALID_BYTE_SIZE;
+            }
+
+            return PropWare::SPI::NO_ERROR;
+        }
+
+#endif
         /**
          * @brief      Print through UART an error string followed by entering
          *             an infinite loop
@@ -681,6 +1568,26 @@ class SPI {
                     printf(str, (err - PropWare::SPI::BEG_ERROR),
                             "Passed in address is miss aligned");
                     break;
+                case PropWare::SPI::INVALID_PROFILE:
+                    printf(str, (err - PropWare::SPI::BEG_ERROR),
+                            "Device profile has not been registered");
+                    break;
+                case PropWare::SPI::TOO_MANY_PROFILES:
+                    printf(str, (err - PropWare::SPI::BEG_ERROR),
+                            "No room for another device profile");
+                    break;
+                case PropWare::SPI::NOT_BUS_OWNER:
+                    printf(str, (err - PropWare::SPI::BEG_ERROR),
+                            "Bus is not owned by the calling cog");
+                    break;
+                case PropWare::SPI::INVALID_BUFFER_SIZE:
+                    printf(str, (err - PropWare::SPI::BEG_ERROR),
+                            "Buffer size is not a power of two");
+                    break;
+                case PropWare::SPI::TOO_MANY_CHANNELS:
+                    printf(str, (err - PropWare::SPI::BEG_ERROR),
+                            "Too many devices for one gang transfer");
+                    break;
                 default:
                     // Is the error an SPI error?
                     if (err > PropWare::SPI::BEG_ERROR
@@ -700,17 +1607,38 @@ class SPI {
          *** Private Constant Definitions ***
          ************************************/
         static const uint16_t TIMEOUT_WIGGLE_ROOM = 400;
-        static const uint8_t FUNC_SEND = 0;
-        static const uint8_t FUNC_READ = 1;
-        static const uint8_t FUNC_SEND_FAST = 2;
-        static const uint8_t FUNC_READ_FAST = 3;
-        static const uint8_t FUNC_READ_SECTOR = 4;
-        static const uint8_t FUNC_SET_MODE = 5;
-        static const uint8_t FUNC_SET_BITMODE = 6;
-        static const uint8_t FUNC_SET_FREQ = 7;
-        static const uint8_t FUNC_GET_FREQ = 8;
 
+        static const uint32_t FUNC_BITS = BYTE_0;
         static const uint8_t BITS_OFFSET = 8;
+        // Sequence number of a mailbox command
+        static const uint8_t SEQUENCE_OFFSET = 16;
+        // Channel count of a gang transfer, in its descriptor's operation
+        static const uint8_t GANG_COUNT_OFFSET = 16;
+
+        // Set in Descriptor::op while the descriptor is owned by the SPI cog
+        static const uint32_t QUEUE_PENDING = BIT_31;
+
+        // Clock cycles spent between bytes of a block transfer on hub access
+        // and loop overhead; Used to scale the block transfer timeout
+        static const uint16_t BLOCK_BYTE_OVERHEAD = 128;
+
+        // Layout of SPI::SDCommand::frame
+        static const uint8_t SD_CRC_OFFSET = 8;
+        static const uint8_t SD_PHASE_OFFSET = 16;
+        static const uint8_t SD_RESPONSE_BITS_OFFSET = 24;
+        // Waits for the card within an SD command, and the bytes of an SD
+        // command shifted in addition to its data block
+        static const uint8_t SD_WAITS = 3;
+        static const uint8_t SD_FRAME_BYTES = 16;
+
+#ifdef SPI_OPTION_VIDEO
+        // The VCO of the PLL is run at CLKFREQ
+        static const uint32_t VIDEO_MIN_CLKFREQ = 64000000;
+        static const uint32_t VIDEO_MAX_CLKFREQ = 128000000;
+        // VGA mode, two colors: one bit per pixel
+        static const uint32_t VIDEO_VGA_MODE = BIT_29;
+        static const uint8_t VIDEO_GROUP_OFFSET = 9;
+#endif
 
         static const uint8_t PHASE_BIT = BIT_0;
         // Idle high == HIGH; Idle low == LOW
@@ -718,57 +1646,357 @@ class SPI {
         // MSB_FIRST == HIGH; LSB_FIRST == LOW
         static const uint8_t BITMODE_BIT = BIT_2;
 
+    protected:
+        /**
+         * @brief   Commands that bypass the descriptor ring; Read by the SPI cog
+         *
+         * Each command carries a sequence number, which the SPI cog copies to
+         * `done` once `result` is valid
+         */
+        typedef struct {
+            /** Function, bits and sequence number; Written last */
+            volatile uint32_t command;
+            /** Parameter of the command; Pointer-sized, as it may be a hub
+             *  address */
+            volatile uintptr_t payload;
+            volatile uint32_t result;
+            /** Sequence number of the last completed command */
+            volatile uint32_t done;
+        } Mailbox;
+
+        /**
+         * @brief   Statistics recorded by the SPI cog itself, directly after the
+         *          profile table
+         */
+        typedef struct {
+            volatile uint32_t busyCycles;
+        } CogStats;
+
+        /**
+         * @brief   Settings of one device on the bus; Read by the SPI cog
+         */
+        typedef struct {
+            uint32_t csMask;
+            uint32_t mode;
+            uint32_t bitMode;
+            uint32_t clkDelay;
+        } Profile;
+
+        /**
+         * @brief   Owns the bus for the lifetime of a single method call,
+         *          unless the calling cog already owns it
+         */
+        class Guard {
+            public:
+                Guard (SPI *spi) {
+                    this->m_spi = spi;
+                    this->m_acquired = spi->acquire();
+                }
+
+                ~Guard () {
+                    if (this->m_acquired)
+                        this->m_spi->release();
+                }
+
+            private:
+                SPI *m_spi;
+                bool m_acquired;
+        };
+
     protected:
         /***********************************
          *** Private Method Declarations ***
          ***********************************/
         /**
-         * @brief       Read the value that the SPI cog just shifted in
+         * @brief   Determine if a profile is registered
+         */
+        bool is_profile (const SPI::ProfileId id) const {
+            return 0 < id && SPI::MAX_PROFILES >= id
+                    && this->m_profiles[id - 1].csMask;
+        }
+
+        /**
+         * @brief   Record the name of the method that failed, truncated if it
+         *          does not fit
+         */
+        void set_error_method (const char method[]) {
+            strncpy(this->m_errorInMethod, method,
+                    sizeof(this->m_errorInMethod) - 1);
+            this->m_errorInMethod[sizeof(this->m_errorInMethod) - 1] = '\0';
+        }
+
+        /**
+         * @brief   Take ownership of the bus unless the calling cog already
+         *          owns it
          *
-         * @param[out]  *par    Address to store the parameter
-         * @param[in]   size    Number of bytes allocated to *data; Example:
-         *                        int newVal;
-         *                        spi.read_par(&newVal, sizeof(newVal));
-         *                      Or if using a pointer:
-         *                        int *newVal;
-         *                        spi.read_par(newVal, sizeof(*newVal));
+         * The owner's own calls never touch the hardware lock, which keeps the
+         * cost of a call within a transaction to a comparison
          *
-         * @return      Returns 0 upon success, error code otherwise
+         * @return  True if ownership was taken by this call
          */
-        PropWare::ErrorCode read_par (void *par, const size_t size) {
-            uint8_t *par8;
-            uint16_t *par16;
-            uint32_t *par32;
-            const uint32_t timeoutCnt = PropWare::SPI::WR_TIMEOUT_VAL + CNT;
+        bool acquire () {
+            const int8_t cog = (int8_t) cogid();
 
-            // Wait for a value to be written
-            while (-1 == this->m_mailbox)
-                if (abs(timeoutCnt - CNT) < PropWare::SPI::TIMEOUT_WIGGLE_ROOM)
-                    return PropWare::SPI::TIMEOUT_RD;
+            if (cog == this->m_owner)
+                return false;
+
+            if (0 <= this->m_lock)
+                while (lockset(this->m_lock))
+                    ;
+            this->m_owner = cog;
+            return true;
+        }
+
+        /**
+         * @brief   Give up ownership of the bus
+         */
+        void release () {
+            this->m_owner = -1;
+            if (0 <= this->m_lock)
+                lockclr(this->m_lock);
+        }
+
+#ifdef SPI_OPTION_VIDEO
+        /**
+         * @brief   VCFG of a video generator driving nothing but MOSI
+         */
+        static uint32_t video_config (const PropWare::Port::Mask mosi) {
+            const uint8_t group = PropWare::Pin::convert(mosi) >> 3;
+
+            return SPI::VIDEO_VGA_MODE
+                    | (group << SPI::VIDEO_GROUP_OFFSET)
+                    | (mosi >> (group << 3));
+        }
+#endif
+
+        /**
+         * @brief   Forget all queued transfers; Only valid while the SPI cog is
+         *          not running
+         */
+        void reset_queue () {
+            for (uint8_t i = 0; i < SPI::QUEUE_LENGTH; ++i)
+                this->m_queue[i].op = 0;
+            this->m_submitted = 0;
+        }
+
+        /**
+         * @brief       Retrieve the ring slot used by a transfer
+         */
+        const SPI::Descriptor* get_slot (const SPI::Ticket ticket) const {
+            return &this->m_queue[ticket % SPI::QUEUE_LENGTH];
+        }
+
+        /**
+         * @brief       Count an operation handed to the SPI cog; Does nothing
+         *              unless SPI_OPTION_STATS is defined
+         *
+         * @param[in]   func        Function code, as handed to the SPI cog
+         * @param[in]   bits        Number of bits per word
+         * @param[in]   length      Number of bytes in a block
+         */
+        void count (const uint32_t func, const uint8_t bits,
+                const uint32_t length = 0) {
+#ifdef SPI_OPTION_STATS
+            const uint8_t code = (uint8_t) (func & SPI::FUNC_BITS);
+
+            ++this->m_stats.calls[code];
+            if (SPI::FUNC_SEND_BLOCK == code || SPI::FUNC_READ_BLOCK == code
+                    || SPI::FUNC_TRANSFER_BLOCK == code)
+                this->m_stats.bits += length << 3;
+            else if (SPI::FUNC_SD_COMMAND == code)
+                this->m_stats.bits += (SPI::SD_FRAME_BYTES + length) << 3;
+            // The bit count of a select or deselect is the profile number
+            else if (SPI::FUNC_SELECT != code && SPI::FUNC_DESELECT != code)
+                this->m_stats.bits += bits;
+#else
+            (void) func;
+            (void) bits;
+            (void) length;
+#endif
+        }
+
+        /**
+         * @brief       Record the time at which an operation is handed to the
+         *              SPI cog; Does nothing unless SPI_OPTION_STATS is defined
+         *
+         * @param[in]   index   Ring slot of a queued transfer, or
+         *                      SPI::QUEUE_LENGTH for the mailbox
+         */
+        void stamp_submission (const uint8_t index) {
+#ifdef SPI_OPTION_STATS
+            this->m_submissionCnt[index] = CNT;
+#else
+            (void) index;
+#endif
+        }
+
+        /**
+         * @brief       Record the completion latency of an operation whose
+         *              completion the calling cog just saw; Does nothing
+         *              unless SPI_OPTION_STATS is defined
+         *
+         * @param[in]   index   Ring slot of a queued transfer, or
+         *                      SPI::QUEUE_LENGTH for the mailbox
+         */
+        void count_completion (const uint8_t index) {
+#ifdef SPI_OPTION_STATS
+            const uint32_t cycles = CNT - this->m_submissionCnt[index];
+
+            if (this->m_stats.maxCompletionCycles < cycles)
+                this->m_stats.maxCompletionCycles = cycles;
+#else
+            (void) index;
+#endif
+        }
+
+        /**
+         * @brief       Compute the timeout for a queued transfer, scaled by its
+         *              length
+         */
+        uint32_t get_queue_timeout (const SPI::Descriptor *slot) const {
+            const uint32_t func = slot->op & SPI::FUNC_BITS;
+            uint32_t length = 1;
+
+            if (SPI::FUNC_SEND_BLOCK == func || SPI::FUNC_READ_BLOCK == func
+                    || SPI::FUNC_TRANSFER_BLOCK == func)
+                length = (uint32_t) slot->length;
+            else if (SPI::FUNC_GANG_TRANSFER == func)
+                // Every channel costs about as much as a byte on every clock
+                length = ((slot->op >> SPI::GANG_COUNT_OFFSET) & BYTE_0)
+                        * ((slot->op >> SPI::BITS_OFFSET) & BYTE_0);
+
+            return SPI::WR_TIMEOUT_VAL + CNT
+                    + length
+                            * ((this->m_clkDelay << 4)
+                                    + SPI::BLOCK_BYTE_OVERHEAD);
+        }
+
+        /**
+         * @brief       Place a transfer in the next slot of the descriptor
+         *              ring, waiting for the slot to be retired if necessary
+         *
+         * @param[in]   func        SPI cog function to be executed, along with
+         *                          any of its parameters above bit 15
+         * @param[in]   bits        Number of bits per word
+         * @param[in]   data        Value to be sent or hub address of a block
+         * @param[in]   length      Number of bytes in a block
+         * @param[out]  *ticket     If not NULL, identifies the transfer
+         *
+         * @return      May return non-zero error code when a timeout occurs
+         */
+        PropWare::ErrorCode enqueue (const uint32_t func, const uint8_t bits,
+                const uintptr_t data, const uintptr_t length,
+                SPI::Ticket *ticket) {
+            const SPI::Guard guard(this);
+            SPI::Descriptor *slot = &this->m_queue[this->m_submitted
+                    % SPI::QUEUE_LENGTH];
+
+            if (SPI::QUEUE_PENDING & slot->op) {
+                const uint32_t timeoutCnt = this->get_queue_timeout(slot);
+
+                while (SPI::QUEUE_PENDING & slot->op)
+                    if (abs(timeoutCnt - CNT) < SPI::TIMEOUT_WIGGLE_ROOM)
+                        return SPI::TIMEOUT;
+            }
+
+            slot->data = data;
+            slot->length = length;
+            this->stamp_submission(this->m_submitted % SPI::QUEUE_LENGTH);
+            // The operation is written last: it hands the slot to the SPI cog
+            slot->op = SPI::QUEUE_PENDING | func | (bits << SPI::BITS_OFFSET);
+            // The length of a gang transfer is an address, which count() ignores
+            this->count(func, bits, (uint32_t) length);
+
+            if (NULL != ticket)
+                *ticket = this->m_submitted;
+            ++this->m_submitted;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Hand one command to the SPI cog through the mailbox
+         *
+         * The payload is written before the command, whose new sequence
+         * number tells the SPI cog that both are valid; Nothing else is
+         * exchanged until the command is done
+         *
+         * @param[in]   func        SPI cog function to be executed
+         * @param[in]   bits        Number of bits per word, if any
+         * @param[in]   payload     Parameter of the function
+         * @param[in]   length      Number of bytes in a block, if any
+         *
+         * @return      May return non-zero error code when a timeout occurs
+         */
+        PropWare::ErrorCode post (const uint8_t func, const uint8_t bits,
+                const uintptr_t payload, const uint32_t length = 0) {
+            PropWare::ErrorCode err;
+
+            check_errors(this->wait());
+
+            ++this->m_sequence;
+            this->m_mailbox.payload = payload;
+            this->stamp_submission(SPI::QUEUE_LENGTH);
+            this->m_mailbox.command = func | (bits << SPI::BITS_OFFSET)
+                    | ((uint32_t) this->m_sequence << SPI::SEQUENCE_OFFSET);
+            this->count(func, bits, length);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Wait for the SPI cog to finish the last command posted
+         *              through the mailbox
+         *
+         * @param[in]   timeoutCnt  Value of CNT at which to give up
+         *
+         * @return      May return non-zero error code when a timeout occurs
+         */
+        PropWare::ErrorCode wait_done (const uint32_t timeoutCnt) {
+            if (this->m_sequence == this->m_mailbox.done)
+                return SPI::NO_ERROR;
+
+            while (this->m_sequence != this->m_mailbox.done)
+                if (abs(timeoutCnt - CNT) < SPI::TIMEOUT_WIGGLE_ROOM)
+                    return SPI::TIMEOUT;
+            this->count_completion(SPI::QUEUE_LENGTH);
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief       Read the result of the last command posted through the
+         *              mailbox
+         *
+         * @param[out]  *par        Address to store the result
+         * @param[in]   size        Number of bytes allocated to *par; Example:
+         *                            int newVal;
+         *                            read_result(&newVal, sizeof(newVal), t);
+         * @param[in]   timeoutCnt  Value of CNT at which to give up
+         *
+         * @return      Returns 0 upon success, error code otherwise
+         */
+        PropWare::ErrorCode read_result (void *par, const size_t size,
+                const uint32_t timeoutCnt) {
+            if (this->wait_done(timeoutCnt))
+                return SPI::TIMEOUT_RD;
 
             // Determine if output variable is char, short or long and write
             // data to that location
             switch (size) {
                 case sizeof(uint8_t):
-                    par8 = (uint8_t *) par;
-                    *par8 = (uint8_t) this->m_mailbox;
+                    *((uint8_t *) par) = (uint8_t) this->m_mailbox.result;
                     break;
                 case sizeof(uint16_t):
-                    par16 = (uint16_t *) par;
-                    *par16 = (uint16_t) this->m_mailbox;
+                    *((uint16_t *) par) = (uint16_t) this->m_mailbox.result;
                     break;
                 case sizeof(uint32_t):
-                    par32 = (uint32_t *) par;
-                    *par32 = (uint32_t) this->m_mailbox;
+                    *((uint32_t *) par) = this->m_mailbox.result;
                     break;
                 default:
-                    return PropWare::SPI::INVALID_BYTE_SIZE;
-                    break;
+                    return SPI::INVALID_BYTE_SIZE;
             }
 
-            // Signal that value is saved and GAS cog can continue execution
-            this->m_mailbox = -1;
-
             return SPI::NO_ERROR;
         }
 
@@ -776,9 +2004,44 @@ class SPI {
         /********************************
          *** Private Member Variables ***
          ********************************/
-        volatile atomic_t m_mailbox;
         int8_t m_cog;
-        char m_errorInMethod[16];
+        uint32_t m_clkDelay;
+        PropWare::Port::Mask m_mosi;
+        uint16_t m_sequence;
+        SPI::Mailbox m_mailbox;
+        // The SPI cog finds the descriptor ring directly after the mailbox
+        SPI::Descriptor m_queue[SPI::QUEUE_LENGTH];
+        // The SPI cog expects the profile table directly after the ring
+        SPI::Profile m_profiles[SPI::MAX_PROFILES];
+#ifdef SPI_OPTION_STATS
+        // ...and its own statistics directly after the profile table
+        SPI::CogStats m_cogStats;
+        SPI::Stats m_stats;
+        uint32_t m_statsStart;
+        // CNT when each ring slot, and then the mailbox, was last handed over
+        uint32_t m_submissionCnt[SPI::QUEUE_LENGTH + 1];
+#endif
+        SPI::Ticket m_submitted;
+        // Hardware lock arbitrating between cogs; -1 if none was available
+        int8_t m_lock;
+        // Cog that owns the bus, -1 while it is free
+        volatile int8_t m_owner;
+        // Number of open SPI::lock() and SPI::select() transactions
+        uint8_t m_ownerDepth;
+        // Long enough for the longest name, "set_video_transmit"
+        char m_errorInMethod[19];
+
+    private:
+        // The cog holds the address of the mailbox: an instance can be neither
+        // copied nor assigned
+        SPI (const SPI &);
+        SPI& operator= (const SPI &);
+
+        // SPIEmulator finds the bus of each emulated cog by its mailbox
+        friend class SPIEmulator;
+
+    private:
+        static SPI s_instance;
     };
 
 }
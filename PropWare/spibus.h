@@ -0,0 +1,283 @@
+/**
+ * @file        spibus.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_SPIBUS_H_
+#define PROPWARE_SPIBUS_H_
+
+#include <stdlib.h>
+#include <PropWare/PropWare.h>
+#include <PropWare/port.h>
+
+namespace PropWare {
+
+/**
+ * @brief   Interface shared by every SPI master, allowing device drivers to
+ *          be written once for any of them
+ *
+ * PropWare::SPI runs the bus from a dedicated assembly cog while
+ * PropWare::InlineSPI bit-bangs it from the calling cog. A driver that only
+ * holds a PropWare::SPIBus pointer works with either one
+ */
+class SPIBus {
+    public:
+        /**
+         * @brief   Descriptor for SPI signal as defined by Motorola modes
+         *
+         * CPOL 0 refers to a low polarity (where the clock idles in the low
+         * state) and CPOL 1 is for high polarity.
+         * TODO: Describe phase
+         * <table><tr><td>SPI Mode</td><td>CPOL</td><td>CPHA</td></tr><tr>
+         * <td>0</td><td>0</td><td>0</td></tr><tr><td>1</td><td>0</td><td>1</td>
+         * </tr><tr><td>2</td><td>1</td><td>0</td></tr><tr><td>3</td><td>1</td>
+         * <td>1</td></tr></table>
+         */
+        /* Raw text version of the above HTML table
+         *
+         * SPI Mode     CPOL    CPHA
+         * 0            0       0
+         * 1            0       1
+         * 2            1       0
+         * 3            1       1
+         */
+        typedef enum {
+            /** Mode 0 */MODE_0,
+            /** Mode 1 */MODE_1,
+            /** Mode 2 */MODE_2,
+            /** Mode 3 */MODE_3,
+        } Mode;
+
+        /**
+         * @brief   Determine if data is communicated with the LSB or MSB
+         *          sent/received first
+         *
+         * @note    Initial value is SPI_MODES + 1 making them easily
+         *          distinguishable
+         */
+        typedef enum {
+            /**
+             * Start the enumeration where SPIBus::Mode left off; this ensures no
+             * overlap
+             */
+            LSB_FIRST = SPIBus::MODE_3 + 1,
+            MSB_FIRST
+        } BitMode;
+
+        /**
+         * Identifies a device profile registered with SPIBus::add_profile()
+         */
+        typedef uint8_t ProfileId;
+
+        /**
+         * @brief   One device of a gang transfer; See SPIBus::gang_transfer()
+         */
+        typedef struct {
+            /** Pin mask of the device's MISO line */
+            uint32_t misoMask;
+            /** Bits received from the device */
+            uint32_t data;
+        } GangChannel;
+
+    public:
+        /**
+         * @brief   Devices hold a bus by SPIBus pointer, so the destructor of
+         *          either implementation must be reachable through one
+         */
+        virtual ~SPIBus () {
+        }
+
+        /**
+         * @brief    Determine if the bus is ready to be used
+         */
+        virtual bool is_running () = 0;
+
+        /**
+         * @brief       Prepare the bus for communication
+         *
+         * @param[in]   mosi        PinNum mask for MOSI
+         * @param[in]   miso        PinNum mask for MISO
+         * @param[in]   sclk        PinNum mask for SCLK
+         * @param[in]   frequency   Frequency, in Hz, to run the SPI clock
+         * @param[in]   mode        One of the 4 Motorola SPI modes
+         * @param[in]   bitmode     One of MSB-first or LSB-first
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode start (const PropWare::Port::Mask mosi,
+                const PropWare::Port::Mask miso,
+                const PropWare::Port::Mask sclk, const int32_t frequency,
+                const SPIBus::Mode mode, const SPIBus::BitMode bitmode) = 0;
+
+        /**
+         * @brief       Register a device on the bus along with the settings it
+         *              requires
+         *
+         * @param[in]   cs          Pin mask for the device's chip select
+         * @param[in]   mode        SPI mode used by the device
+         * @param[in]   bitmode     Bit order used by the device
+         * @param[in]   frequency   Frequency, in Hz, to run the SPI clock for
+         *                          the device
+         * @param[out]  *id         Identifies the new profile
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode add_profile (const PropWare::Port::Mask cs,
+                const SPIBus::Mode mode, const SPIBus::BitMode bitmode,
+                const int32_t frequency, SPIBus::ProfileId *id) = 0;
+
+        /**
+         * @brief       Remove a device registered with SPIBus::add_profile();
+         *              Its chip select is left driven high
+         *
+         * @param[in]   id      Profile returned by SPIBus::add_profile()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode remove_profile (
+                const SPIBus::ProfileId id) = 0;
+
+        /**
+         * @brief       Apply a device's settings and assert its chip select
+         *
+         * @param[in]   id      Profile returned by SPIBus::add_profile()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode select (const SPIBus::ProfileId id) = 0;
+
+        /**
+         * @brief       Deassert a device's chip select
+         *
+         * @param[in]   id      Profile returned by SPIBus::add_profile()
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode deselect (const SPIBus::ProfileId id) = 0;
+
+        /**
+         * @brief       Send a value out to a peripheral device
+         *
+         * The send may be posted: it is only guaranteed to have reached the
+         * bus once a later transfer has completed or SPIBus::fence() has
+         * returned
+         *
+         * @param[in]   bits        Number of bits to be shifted out
+         * @param[in]   value       The value to be shifted out
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode shift_out (uint8_t bits,
+                uint32_t value) = 0;
+
+        /**
+         * @brief       Receive a value in from a peripheral device
+         *
+         * @param[in]   bits    Number of bits to be shifted in
+         * @param[out]  *data   Received data will be stored at this address
+         * @param[in]   size    Number of bytes allocated to *data
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode shift_in (const uint8_t bits, void *data,
+                const size_t size) = 0;
+
+        /**
+         * @brief       Send an entire buffer out to a peripheral device; Does
+         *              not return until the last byte has been shifted out
+         *
+         * @param[in]   buffer[]        First byte to send
+         * @param[in]   numberOfBytes   Number of bytes to be shifted out
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode shift_out_block (const uint8_t buffer[],
+                const size_t numberOfBytes) = 0;
+
+        /**
+         * @brief       Receive an entire buffer in from a peripheral device
+         *
+         * @param[out]  buffer[]        Where the first byte should be written
+         * @param[in]   numberOfBytes   Number of bytes to be shifted in
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode shift_in_block (uint8_t buffer[],
+                const size_t numberOfBytes) = 0;
+
+        /**
+         * @brief       Send and receive a value simultaneously
+         *
+         * @param[in]   bits    Number of bits to be exchanged
+         * @param[in]   out     The value to be shifted out
+         * @param[out]  *in     The value shifted in is stored here
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode transfer (const uint8_t bits,
+                const uint32_t out, uint32_t *in) = 0;
+
+        /**
+         * @brief       Send a value to several devices at once while receiving
+         *              from all of them simultaneously
+         *
+         * Every device shares MOSI and SCLK but drives its own MISO pin, all
+         * of which are sampled on the same clock edges. Bits are always
+         * shifted MSB first
+         *
+         * @param[in]       bits        Number of bits to be exchanged
+         * @param[in]       out         The value to be shifted out
+         * @param[in,out]   channels[]  MISO pin mask of each device; The bits
+         *                              received from each device are stored
+         *                              alongside its mask
+         * @param[in]       count       Number of devices
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        virtual PropWare::ErrorCode gang_transfer (const uint8_t bits,
+                const uint32_t out, SPIBus::GangChannel channels[],
+                const uint8_t count) = 0;
+
+        /**
+         * @brief   Wait for every posted send to reach the bus; Required before
+         *          a chip select that is driven by the caller, rather than by
+         *          SPIBus::deselect(), is released
+         *
+         * Transfers on the bus are executed in order, so there is no need for
+         * a fence between a send and a subsequent read or deselect
+         *
+         * @return  May return non-zero error code when a timeout occurs
+         */
+        virtual PropWare::ErrorCode fence () = 0;
+
+        /**
+         * @brief   Wait for every transfer to complete
+         *
+         * @return  May return non-zero error code when a timeout occurs
+         */
+        virtual PropWare::ErrorCode wait () = 0;
+};
+
+}
+
+#endif /* PROPWARE_SPIBUS_H_ */
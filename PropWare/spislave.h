@@ -0,0 +1,292 @@
+/**
+ * @file        spislave.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_SPISLAVE_H_
+#define PROPWARE_SPISLAVE_H_
+
+#include <propeller.h>
+#include <PropWare/PropWare.h>
+#include <PropWare/port.h>
+#include <PropWare/spi.h>
+
+namespace PropWare {
+
+// Symbol for assembly instructions to start a new SPI slave cog
+extern "C" {
+extern uint32_t _SPISlaveStartCog (void *arg);
+}
+
+/**
+ * @brief       SPI peripheral for another microcontroller; A dedicated assembly
+ *              cog follows the master's SCLK and chip select
+ *
+ * Bytes received are stored in a receive ring and bytes to be sent are taken
+ * from a transmit ring, both in hub RAM and both supplied by the caller. The
+ * cog moves every byte itself: nothing is required of the calling cog while a
+ * frame is in progress. Each ring's size must be a power of two.
+ *
+ * Data is shifted MSB first, in any of the four SPI modes. MISO is only driven
+ * while chip select is low. When the transmit ring runs dry, the fill byte is
+ * sent instead. A byte is only taken from the transmit ring once all eight of
+ * its bits have been clocked out; If the master ends the frame part way
+ * through a byte, that byte is sent again in the next frame and the partial
+ * byte received is discarded. A byte received while the receive ring is full
+ * is dropped and counted by SPISlave::get_overruns().
+ *
+ * Timing, with CLKFREQ the system clock:
+ * <ul><li>No bit takes more than 64 cycles, so SCLK may run at up to
+ * CLKFREQ/64 (1.25 MHz at 80 MHz). Allow for the master's setup time as well:
+ * CLKFREQ/80 (1 MHz at 80 MHz) is recommended</li>
+ * <li>The first bit is valid on MISO about 10 cycles (125 ns at 80 MHz) after
+ * chip select is asserted, provided the transmit ring was not empty when the
+ * previous frame ended; Otherwise the cog polls the ring and may take up to
+ * 120 cycles (1.5 us at 80 MHz)</li>
+ * <li>The first SCLK edge must follow chip select by at least 150 cycles
+ * (1.9 us at 80 MHz)</li></ul>
+ */
+class SPISlave {
+    public:
+        /**
+         * @brief   Shared with the SPI slave cog; Everything above rxHead is
+         *          only read when the cog starts
+         */
+        typedef struct {
+            uint32_t mosi;
+            uint32_t miso;
+            uint32_t sclk;
+            uint32_t cs;
+            uint32_t mode;
+            uint32_t rxBuffer;
+            uint32_t rxMask;
+            uint32_t txBuffer;
+            uint32_t txMask;
+            uint32_t fill;
+            /** Bytes written to the receive ring; Written by the cog */
+            volatile uint32_t rxHead;
+            /** Bytes read from the receive ring */
+            volatile uint32_t rxTail;
+            /** Bytes written to the transmit ring */
+            volatile uint32_t txHead;
+            /** Bytes sent from the transmit ring; Written by the cog */
+            volatile uint32_t txTail;
+            /** Written by the cog at the end of each frame */
+            volatile uint32_t overruns;
+            /** Written by the cog at the end of each frame */
+            volatile uint32_t frames;
+            /** Bytes dropped by the cog are written here */
+            volatile uint32_t discard;
+        } Control;
+
+    public:
+        /**
+         * @brief       Supply the rings; Neither may be used by anything else
+         *              until the cog is stopped
+         *
+         * @param[in]   rxBuffer[]  Receive ring
+         * @param[in]   rxSize      Number of bytes in rxBuffer; A power of two
+         * @param[in]   txBuffer[]  Transmit ring
+         * @param[in]   txSize      Number of bytes in txBuffer; A power of two
+         */
+        SPISlave (uint8_t rxBuffer[], const uint16_t rxSize,
+                uint8_t txBuffer[], const uint16_t txSize) {
+            this->m_rxBuffer = rxBuffer;
+            this->m_rxSize = rxSize;
+            this->m_txBuffer = txBuffer;
+            this->m_txSize = txSize;
+            this->m_cog = -1;
+        }
+
+        ~SPISlave () {
+            this->stop();
+        }
+
+        /**
+         * @brief       Start the SPI slave cog; Any bytes in either ring are
+         *              discarded
+         *
+         * @param[in]   mosi    Pin mask for MOSI, an input
+         * @param[in]   miso    Pin mask for MISO, driven only while selected
+         * @param[in]   sclk    Pin mask for SCLK, an input
+         * @param[in]   cs      Pin mask for chip select, an input
+         * @param[in]   mode    One of the 4 Motorola SPI modes
+         * @param[in]   fill    Byte sent while the transmit ring is empty
+         *
+         * @return      Returns 0 upon success, otherwise error code;
+         *              SPI::INVALID_BUFFER_SIZE if either ring's size is not a
+         *              power of two
+         */
+        PropWare::ErrorCode start (const PropWare::Port::Mask mosi,
+                const PropWare::Port::Mask miso,
+                const PropWare::Port::Mask sclk, const PropWare::Port::Mask cs,
+                const SPIBus::Mode mode, const uint8_t fill = 0xff) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (SPIBus::MODE_3 < mode)
+                return SPI::INVALID_MODE;
+#endif
+            // The rings are indexed by masking: any other size scrambles them
+            if (!SPISlave::is_power_of_two(this->m_rxSize)
+                    || !SPISlave::is_power_of_two(this->m_txSize))
+                return SPI::INVALID_BUFFER_SIZE;
+
+            if (this->is_running())
+                this->stop();
+
+            memset(&this->m_control, 0, sizeof(this->m_control));
+            this->m_control.mosi = mosi;
+            this->m_control.miso = miso;
+            this->m_control.sclk = sclk;
+            this->m_control.cs = cs;
+            this->m_control.mode = mode;
+            this->m_control.rxBuffer = (uint32_t) this->m_rxBuffer;
+            this->m_control.rxMask = this->m_rxSize - 1U;
+            this->m_control.txBuffer = (uint32_t) this->m_txBuffer;
+            this->m_control.txMask = this->m_txSize - 1U;
+            this->m_control.fill = fill;
+
+            this->m_cog = (int8_t) PropWare::_SPISlaveStartCog(
+                    (void *) &this->m_control);
+            if (!this->is_running())
+                return SPI::COG_NOT_STARTED;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Stop the SPI slave cog, releasing MISO
+         */
+        void stop () {
+            if (this->is_running()) {
+                cogstop(this->m_cog);
+                this->m_cog = -1;
+            }
+        }
+
+        /**
+         * @brief   Determine if the SPI slave cog is running
+         */
+        bool is_running () const {
+            return -1 != this->m_cog;
+        }
+
+        /**
+         * @brief   Number of bytes waiting in the receive ring
+         */
+        uint16_t available () const {
+            return (uint16_t) (this->m_control.rxHead
+                    - this->m_control.rxTail);
+        }
+
+        /**
+         * @brief       Take bytes from the receive ring without waiting
+         *
+         * @param[out]  data[]  Bytes received
+         * @param[in]   length  Maximum number of bytes to take
+         *
+         * @return      Number of bytes taken
+         */
+        uint16_t receive (uint8_t data[], uint16_t length) {
+            const uint32_t head = this->m_control.rxHead;
+            uint32_t tail = this->m_control.rxTail;
+
+            if (head - tail < length)
+                length = (uint16_t) (head - tail);
+            for (uint16_t i = 0; i < length; ++i, ++tail)
+                data[i] = this->m_rxBuffer[tail & this->m_control.rxMask];
+
+            // Hand the slots back only once they have been copied
+            this->m_control.rxTail = tail;
+            return length;
+        }
+
+        /**
+         * @brief   Number of bytes that can be added to the transmit ring
+         */
+        uint16_t space () const {
+            return (uint16_t) (this->m_txSize - (this->m_control.txHead
+                    - this->m_control.txTail));
+        }
+
+        /**
+         * @brief       Add bytes to the transmit ring without waiting; They
+         *              are sent as the master clocks them out
+         *
+         * @param[in]   data[]  Bytes to send
+         * @param[in]   length  Number of bytes to send
+         *
+         * @return      Number of bytes added, less than length if the ring
+         *              filled up
+         */
+        uint16_t send (const uint8_t data[], uint16_t length) {
+            uint32_t head = this->m_control.txHead;
+
+            if (this->space() < length)
+                length = this->space();
+            for (uint16_t i = 0; i < length; ++i, ++head)
+                this->m_txBuffer[head & this->m_control.txMask] = data[i];
+
+            // The bytes must be in place before the cog can see them
+            this->m_control.txHead = head;
+            return length;
+        }
+
+        /**
+         * @brief   Number of bytes dropped because the receive ring was full,
+         *          as of the end of the last frame
+         */
+        uint32_t get_overruns () const {
+            return this->m_control.overruns;
+        }
+
+        /**
+         * @brief   Number of frames (chip select asserted and released) since
+         *          the cog was started
+         */
+        uint32_t get_frames () const {
+            return this->m_control.frames;
+        }
+
+    protected:
+        static bool is_power_of_two (const uint16_t size) {
+            return size && !(size & (size - 1));
+        }
+
+    protected:
+        SPISlave::Control m_control;
+        uint8_t *m_rxBuffer;
+        uint16_t m_rxSize;
+        uint8_t *m_txBuffer;
+        uint16_t m_txSize;
+        int8_t m_cog;
+
+    private:
+        // The cog holds the address of the control block: an instance can be
+        // neither copied nor assigned
+        SPISlave (const SPISlave &);
+        SPISlave& operator= (const SPISlave &);
+};
+
+}
+
+#endif /* PROPWARE_SPISLAVE_H_ */
@@ -134,8 +134,12 @@ class UART {
              * The requested stop bit width is not between 1 and 14 (inclusive)
              */
             INVALID_STOP_BIT_WIDTH,
+            /** A buffer's size is not a power of two */
+            INVALID_BUFFER_SIZE,
+            /** No cog was free to run in the background */
+            COG_NOT_STARTED,
             /** Last error code used by PropWare::UART */
-            END_ERROR = PropWare::UART::INVALID_STOP_BIT_WIDTH
+            END_ERROR = PropWare::UART::COG_NOT_STARTED
         } ErrorCode;
 
     public:
@@ -554,7 +558,8 @@ class SimplexUART: public PropWare::UART {
  * receive buffer (data sent to the Propeller will be ignored if execution is
  * not in the receive() method) PropWare::FullDuplexUART::receive() will not
  * return until after the RX pin is low and all data, parity (if applicable) and
- * stop bits have been read.
+ * stop bits have been read. PropWare::BufferedUART receives in the background
+ * instead.
  */
 class FullDuplexUART: public PropWare::SimplexUART {
     public:
@@ -0,0 +1,323 @@
+/**
+ * @file        waveplayer.h
+ *
+ * @author      David Zemon
+ *
+ * @copyright
+ * The MIT License (MIT)<br>
+ * <br>Copyright (c) 2013 David Zemon<br>
+ * <br>Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:<br>
+ * <br>The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.<br>
+ * <br>THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROPWARE_WAVEPLAYER_H_
+#define PROPWARE_WAVEPLAYER_H_
+
+#include <propeller.h>
+#include <PropWare/PropWare.h>
+#include <PropWare/port.h>
+#include <PropWare/spi.h>
+#include <PropWare/sd.h>
+
+namespace PropWare {
+
+// Symbol for assembly instructions to start a new wave player cog
+extern "C" {
+extern uint32_t _WavePlayerStartCog (void *arg);
+}
+
+/**
+ * @brief       Play samples from a file on an SD card out to an SPI DAC at a
+ *              fixed sample rate
+ *
+ * A dedicated assembly cog sends one sample to the DAC every sample period,
+ * timed by WAITCNT, so the rate does not depend on the SD card or the calling
+ * cog. The calling cog reads the file a sector at a time into one of two
+ * buffers while the player cog plays the other. Should a buffer not be ready
+ * in time, the DAC holds its last sample for that period and the miss is
+ * counted by WavePlayer::get_underruns(); Playback resumes on schedule as soon
+ * as the buffer arrives.
+ *
+ * The DAC is given its own MOSI, SCLK and chip select pins: the SPI bus used
+ * by the SD card is busy for most of each sector read and could not deliver
+ * samples on time. Each sample is clocked out MSB first in SPI mode 0 at about
+ * CLKFREQ/20 (4 MHz at 80 MHz) with chip select held low for the whole word;
+ * Most DACs, such as the MCP49xx, update their output when chip select rises.
+ * Files hold mono, headerless samples in either of the formats used by WAV
+ * files; Seek past any header before calling WavePlayer::play().
+ *
+ * Reading a sector takes the SD driver roughly 4.5 ms at its default clock of
+ * 900 kHz, which is 256 16-bit samples at no more than about 55 kHz; Raise the
+ * SPI clock with SPI::set_clock() for higher sample rates.
+ */
+class WavePlayer {
+    public:
+        /**
+         * Formats of the samples in a file
+         */
+        typedef enum {
+            /** Unsigned bytes, centred on 0x80 */UNSIGNED_8,
+            /** Signed, least significant byte first */SIGNED_16
+        } SampleFormat;
+
+        /**
+         * @brief   Shared with the wave player cog; The pins are only read
+         *          when the cog starts and the period and format only when
+         *          playback begins
+         */
+        typedef struct {
+            uint32_t mosi;
+            uint32_t sclk;
+            uint32_t cs;
+            /** Clock cycles per sample */
+            uint32_t period;
+            uint32_t justify;
+            uint32_t xorMask;
+            uint32_t drop;
+            uint32_t align;
+            uint32_t command;
+            uint32_t wordBits;
+            uint32_t sampleBytes;
+            uint32_t buffer[2];
+            /** Bytes to play; Written back as zero by the cog when done */
+            volatile uint32_t length[2];
+            /** Non-zero while more buffers are on their way */
+            volatile uint32_t streaming;
+            /** Incremented by the cog for every sample period missed */
+            volatile uint32_t underruns;
+        } Control;
+
+        /** Number of bytes in each of the two buffers */
+        static const uint16_t BUFFER_SIZE = SD::SECTOR_SIZE;
+        /** Clock cycles needed per sample, apart from one per bit sent */
+        static const uint32_t MIN_PERIOD_OVERHEAD = 176;
+        /** Clock cycles needed per bit sent to the DAC */
+        static const uint32_t BIT_CYCLES = 20;
+
+    public:
+        /**
+         * @param[in]   *sd     Mounted SD card to read files from
+         */
+        WavePlayer (SD *sd) {
+            this->m_sd = sd;
+            this->m_cog = -1;
+        }
+
+        ~WavePlayer () {
+            this->stop();
+        }
+
+        /**
+         * @brief       Start the wave player cog and describe the DAC; Chip
+         *              select is driven high until playback begins
+         *
+         * The DAC word is formed by placing the sample, cut to the DAC's
+         * resolution, `dataShift` bits above the LSB of the word and then
+         * setting the command bits. For an MCP4921 (12 bits, buffered, gain of
+         * one, active) that is `start(mosi, sclk, cs, 16, 12, 0, 0x3000)`
+         *
+         * @param[in]   mosi        Pin mask for the DAC's data input
+         * @param[in]   sclk        Pin mask for the DAC's clock
+         * @param[in]   cs          Pin mask for the DAC's chip select
+         * @param[in]   wordBits    Bits sent to the DAC per sample; At most 32
+         * @param[in]   resolution  Bits of each sample used; At most 16
+         * @param[in]   dataShift   Position of the sample's LSB in the DAC word
+         * @param[in]   command     Bits sent with every sample, such as the
+         *                          DAC's configuration bits
+         *
+         * @return      Returns 0 upon success, otherwise error code
+         */
+        PropWare::ErrorCode start (const PropWare::Port::Mask mosi,
+                const PropWare::Port::Mask sclk, const PropWare::Port::Mask cs,
+                const uint8_t wordBits, const uint8_t resolution,
+                const uint8_t dataShift = 0, const uint32_t command = 0) {
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (32 < wordBits || 16 < resolution || !resolution
+                    || wordBits < resolution + dataShift)
+                return SPI::TOO_MANY_BITS;
+#endif
+
+            if (this->is_running())
+                this->stop();
+
+            memset(&this->m_control, 0, sizeof(this->m_control));
+            this->m_control.mosi = mosi;
+            this->m_control.sclk = sclk;
+            this->m_control.cs = cs;
+            this->m_control.drop = 32U - resolution;
+            this->m_control.align = 32U - wordBits + dataShift;
+            this->m_control.command = command << (32U - wordBits);
+            this->m_control.wordBits = wordBits;
+            this->m_control.buffer[0] = (uint32_t) this->m_buffers[0];
+            this->m_control.buffer[1] = (uint32_t) this->m_buffers[1];
+            this->m_next = 0;
+
+            this->m_cog = (int8_t) PropWare::_WavePlayerStartCog(
+                    (void *) &this->m_control);
+            if (!this->is_running())
+                return SPI::COG_NOT_STARTED;
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Stop the wave player cog, releasing the DAC's pins
+         */
+        void stop () {
+            if (this->is_running()) {
+                cogstop(this->m_cog);
+                this->m_cog = -1;
+            }
+        }
+
+        /**
+         * @brief   Determine if the wave player cog is running
+         */
+        bool is_running () const {
+            return -1 != this->m_cog;
+        }
+
+        /**
+         * @brief       Play a file from its read pointer to its end; Returns
+         *              once the last sample has been sent
+         *
+         * The calling cog spends the whole of playback reading the file, so
+         * nothing else should be asked of it until this returns
+         *
+         * @pre         *f must be opened for reading
+         *
+         * @param[in]   *f          File of samples
+         * @param[in]   sampleRate  Samples per second
+         * @param[in]   format      Format of the samples in the file
+         *
+         * @return      Returns 0 upon success, otherwise error code; Underruns
+         *              are not errors and are counted instead
+         */
+        PropWare::ErrorCode play (SD::File *f, const uint32_t sampleRate,
+                const WavePlayer::SampleFormat format) {
+            PropWare::ErrorCode err;
+
+            if (!this->is_running())
+                return SPI::MODULE_NOT_RUNNING;
+#ifdef SPI_OPTION_DEBUG_PARAMS
+            if (!sampleRate || CLKFREQ / sampleRate
+                    < WavePlayer::MIN_PERIOD_OVERHEAD
+                            + WavePlayer::BIT_CYCLES * this->m_control.wordBits)
+                return SPI::INVALID_FREQ;
+#endif
+
+            // The cog is idle, so its format may be changed freely
+            this->m_control.period = CLKFREQ / sampleRate;
+            if (WavePlayer::UNSIGNED_8 == format) {
+                this->m_control.sampleBytes = 1;
+                this->m_control.justify = 24;
+                this->m_control.xorMask = 0;
+            } else {
+                this->m_control.sampleBytes = 2;
+                this->m_control.justify = 16;
+                this->m_control.xorMask = BIT_31;
+            }
+            this->m_control.underruns = 0;
+            this->m_control.streaming = 1;
+            err = this->stream(f);
+
+            // Every buffer has been handed over, or an error stopped the
+            // stream; Either way, let the cog drain both
+            this->m_control.streaming = 0;
+            while (this->m_control.length[0] || this->m_control.length[1])
+                ;
+
+            return err;
+        }
+
+        /**
+         * @brief   Number of sample periods in which the DAC held its last
+         *          sample because the next buffer was late, counted since the
+         *          current or last call to WavePlayer::play() began
+         */
+        uint32_t get_underruns () const {
+            return this->m_control.underruns;
+        }
+
+    protected:
+        /**
+         * @brief   Keep both buffers filled until the whole file has been
+         *          handed to the cog
+         */
+        PropWare::ErrorCode stream (SD::File *f) {
+            PropWare::ErrorCode err;
+            const uint8_t first = this->m_next;
+            uint32_t length[2];
+
+            // Fill both buffers before the cog is allowed to start, handing
+            // over the one to be played first last
+            check_errors(this->fill(f, first, &length[0]));
+            check_errors(this->fill(f, first ^ 1, &length[1]));
+            this->m_control.length[first ^ 1] = length[1];
+            this->m_control.length[first] = length[0];
+
+            // The cog moves on to the other buffer after every buffer it
+            // plays, so m_next must follow the buffers it is actually given
+            if (length[0] && !length[1])
+                this->m_next = first ^ 1;
+
+            while (!this->m_sd->feof(f)) {
+                // Wait for the cog to finish with the older buffer
+                while (this->m_control.length[this->m_next])
+                    ;
+                check_errors(this->fill(f, this->m_next, &length[0]));
+                if (length[0]) {
+                    this->m_control.length[this->m_next] = length[0];
+                    this->m_next ^= 1;
+                }
+            }
+
+            return SPI::NO_ERROR;
+        }
+
+        /**
+         * @brief   Read the file into one buffer, dropping any partial sample
+         *          from the end of the file
+         */
+        PropWare::ErrorCode fill (SD::File *f, const uint8_t buffer,
+                uint32_t *length) {
+            PropWare::ErrorCode err;
+
+            check_errors(
+                    this->m_sd->fread(f, (uint8_t *) this->m_buffers[buffer],
+                            WavePlayer::BUFFER_SIZE, length));
+            *length -= *length % this->m_control.sampleBytes;
+            return SPI::NO_ERROR;
+        }
+
+    protected:
+        SD *m_sd;
+        WavePlayer::Control m_control;
+        /** Longs, so that 16-bit samples are always word aligned */
+        uint32_t m_buffers[2][WavePlayer::BUFFER_SIZE / sizeof(uint32_t)];
+        uint8_t m_next;
+        int8_t m_cog;
+
+    private:
+        // The cog holds the addresses of the control block and the sample
+        // buffers: an instance can be neither copied nor assigned
+        WavePlayer (const WavePlayer &);
+        WavePlayer& operator= (const WavePlayer &);
+};
+
+}
+
+#endif /* PROPWARE_WAVEPLAYER_H_ */